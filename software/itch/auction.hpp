@@ -0,0 +1,423 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "constant.hpp" // Side
+#include "rng.hpp"      // deterministic random source
+#include "checkpoint.hpp" // state save/restore
+
+// Opening and closing cross simulation. Computes the values carried by the
+// NOII and Cross Trade messages from resting book state plus cross-only
+// (on-open / on-close) interest, and knows when they are disseminated.
+
+struct AuctionConfig {
+    bool enabled = true;
+    uint64_t open_noii_start_ns = 34'200'000'000'000ULL - 300'000'000'000ULL;   // 09:25:00
+    uint64_t open_fast_start_ns = 34'200'000'000'000ULL - 120'000'000'000ULL;   // 09:28:00
+    uint64_t close_noii_start_ns = 57'600'000'000'000ULL - 600'000'000'000ULL;  // 15:50:00
+    uint64_t close_fast_start_ns = 57'600'000'000'000ULL - 300'000'000'000ULL;  // 15:55:00
+    uint64_t slow_interval_ns = 10'000'000'000ULL;                              // Every 10 s early in the window
+    uint64_t fast_interval_ns = 1'000'000'000ULL;                               // Every second near the cross
+    uint32_t initial_cross_orders = 4;       // Cross-only orders per symbol when the window opens
+    double new_cross_order_probability = 0.3; // Chance per symbol per dissemination of another one
+    uint32_t max_cross_order_lots = 50;
+    uint32_t max_cross_offset_ticks = 30;
+};
+
+inline void saveAuctionConfig(CheckpointWriter &out, const AuctionConfig &config) {
+    out.u8(config.enabled ? 1 : 0);
+    out.u64(config.open_noii_start_ns);
+    out.u64(config.open_fast_start_ns);
+    out.u64(config.close_noii_start_ns);
+    out.u64(config.close_fast_start_ns);
+    out.u64(config.slow_interval_ns);
+    out.u64(config.fast_interval_ns);
+    out.u32(config.initial_cross_orders);
+    out.f64(config.new_cross_order_probability);
+    out.u32(config.max_cross_order_lots);
+    out.u32(config.max_cross_offset_ticks);
+}
+
+inline AuctionConfig loadAuctionConfig(CheckpointReader &in) {
+    AuctionConfig config;
+    config.enabled = in.u8() != 0;
+    config.open_noii_start_ns = in.u64();
+    config.open_fast_start_ns = in.u64();
+    config.close_noii_start_ns = in.u64();
+    config.close_fast_start_ns = in.u64();
+    config.slow_interval_ns = in.u64();
+    config.fast_interval_ns = in.u64();
+    config.initial_cross_orders = in.u32();
+    config.new_cross_order_probability = in.f64();
+    config.max_cross_order_lots = in.u32();
+    config.max_cross_offset_ticks = in.u32();
+    return config;
+}
+
+// One price level of auction interest. Market orders are held separately.
+struct AuctionLevel {
+    uint32_t price;
+    uint64_t shares;
+};
+
+// Interest on both sides of one symbol.
+struct AuctionInterest {
+    std::vector<AuctionLevel> buys;
+    std::vector<AuctionLevel> sells;
+    uint64_t market_buy = 0;
+    uint64_t market_sell = 0;
+
+    void clear() {
+        buys.clear();
+        sells.clear();
+        market_buy = 0;
+        market_sell = 0;
+    }
+
+    bool empty() const {
+        return buys.empty() && sells.empty() && market_buy == 0 && market_sell == 0;
+    }
+};
+
+struct CrossPoint {
+    uint32_t price = 0;          // 0 when no price can be determined
+    uint64_t paired_shares = 0;
+    uint64_t buy_shares = 0;     // Executable buy interest at price
+    uint64_t sell_shares = 0;    // Executable sell interest at price
+};
+
+// Reusable buffers for findCrossPoint so repeated calls do not allocate.
+struct CrossScratch {
+    std::vector<uint32_t> candidates;
+    std::vector<AuctionLevel> buys;
+    std::vector<AuctionLevel> sells;
+};
+
+// Finds the price within [low, high] that maximizes paired shares, then
+// minimizes imbalance, then is closest to anchor; the Nasdaq cross rules.
+// Interest from several sources is combined, and the sweep over candidate
+// prices is linear once the levels are sorted.
+inline CrossPoint findCrossPoint(const AuctionInterest* const* sources, size_t source_count,
+                                 uint32_t low, uint32_t high, uint32_t anchor,
+                                 CrossScratch &scratch) {
+    scratch.candidates.clear();
+    scratch.buys.clear();
+    scratch.sells.clear();
+    uint64_t market_buy = 0;
+    uint64_t market_sell = 0;
+    uint64_t total_buy = 0;
+    for (size_t s = 0; s < source_count; ++s) {
+        const AuctionInterest &interest = *sources[s];
+        market_buy += interest.market_buy;
+        market_sell += interest.market_sell;
+        scratch.buys.insert(scratch.buys.end(), interest.buys.begin(), interest.buys.end());
+        scratch.sells.insert(scratch.sells.end(), interest.sells.begin(), interest.sells.end());
+    }
+    auto by_price = [](const AuctionLevel &a, const AuctionLevel &b) { return a.price < b.price; };
+    std::sort(scratch.buys.begin(), scratch.buys.end(), by_price);
+    std::sort(scratch.sells.begin(), scratch.sells.end(), by_price);
+    for (const AuctionLevel &level : scratch.buys) {
+        total_buy += level.shares;
+        if (level.price >= low && level.price <= high) scratch.candidates.push_back(level.price);
+    }
+    for (const AuctionLevel &level : scratch.sells) {
+        if (level.price >= low && level.price <= high) scratch.candidates.push_back(level.price);
+    }
+    if (low > 0) scratch.candidates.push_back(low);
+    if (high != UINT32_MAX) scratch.candidates.push_back(high);
+    std::sort(scratch.candidates.begin(), scratch.candidates.end());
+    scratch.candidates.erase(std::unique(scratch.candidates.begin(), scratch.candidates.end()),
+                             scratch.candidates.end());
+
+    CrossPoint best;
+    uint64_t best_imbalance = UINT64_MAX;
+    uint32_t best_distance = UINT32_MAX;
+    size_t buy_index = 0;
+    size_t sell_index = 0;
+    uint64_t buy_below = 0;   // Buy limit shares priced under the candidate
+    uint64_t sell_at_or_below = 0;
+    for (uint32_t price : scratch.candidates) {
+        while (buy_index < scratch.buys.size() && scratch.buys[buy_index].price < price) {
+            buy_below += scratch.buys[buy_index++].shares;
+        }
+        while (sell_index < scratch.sells.size() && scratch.sells[sell_index].price <= price) {
+            sell_at_or_below += scratch.sells[sell_index++].shares;
+        }
+        uint64_t buy = market_buy + total_buy - buy_below;
+        uint64_t sell = market_sell + sell_at_or_below;
+        uint64_t paired = std::min(buy, sell);
+        uint64_t imbalance = buy > sell ? buy - sell : sell - buy;
+        uint32_t distance = price > anchor ? price - anchor : anchor - price;
+        bool better = paired > best.paired_shares
+            || (paired == best.paired_shares && imbalance < best_imbalance)
+            || (paired == best.paired_shares && imbalance == best_imbalance && distance < best_distance);
+        if (better) {
+            best = CrossPoint{price, paired, buy, sell};
+            best_imbalance = imbalance;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+struct AuctionResult {
+    uint64_t paired_shares = 0;
+    uint64_t imbalance_shares = 0;
+    char imbalance_direction = 'O';        // 'B', 'S', 'N', or 'O' (insufficient orders)
+    uint32_t far_price = 0;                // Cross-only interest
+    uint32_t near_price = 0;               // Cross-only plus continuous book
+    uint32_t reference_price = 0;          // Within the inside, at which paired/imbalance are quoted
+    char price_variation_indicator = ' ';
+};
+
+// Deviation of near price from reference price as carried in the NOII.
+inline char priceVariationIndicator(uint32_t near_price, uint32_t reference_price) {
+    if (near_price == 0 || reference_price == 0) {
+        return ' ';
+    }
+    uint64_t diff = near_price > reference_price ? near_price - reference_price : reference_price - near_price;
+    uint64_t basis_points = diff * 10'000 / reference_price;
+    if (basis_points < 100) return 'L';
+    if (basis_points < 1'000) return static_cast<char>('0' + basis_points / 100);
+    if (basis_points < 2'000) return 'A';
+    if (basis_points < 3'000) return 'B';
+    return 'C';
+}
+
+// Per-symbol auction state for one cross (open or close).
+class AuctionSimulator {
+public:
+    explicit AuctionSimulator(const AuctionConfig &config = AuctionConfig{}, uint64_t seed = 1)
+        : config_(config), rng_(seed ^ 0xA0C7105EEDULL) {}
+
+    const AuctionConfig &config() const { return config_; }
+
+    // Next NOII dissemination time strictly after now, or UINT64_MAX if none
+    // remain today. Times are ns since midnight.
+    uint64_t nextDissemination(uint64_t now, uint64_t market_open_ns, uint64_t market_close_ns) const {
+        if (!config_.enabled) return UINT64_MAX;
+        uint64_t next = nextInWindow(now, config_.open_noii_start_ns, config_.open_fast_start_ns, market_open_ns);
+        if (next != UINT64_MAX) return next;
+        return nextInWindow(now, config_.close_noii_start_ns, config_.close_fast_start_ns, market_close_ns);
+    }
+
+    // Seeds cross-only interest for every symbol when a window opens.
+    void begin(char cross_type, const std::vector<uint32_t> &last_prices, uint32_t tick, uint32_t round_lot) {
+        cross_type_ = cross_type;
+        tick_ = tick;
+        round_lot_ = round_lot;
+        cross_only_.assign(last_prices.size(), AuctionInterest{});
+        for (size_t i = 0; i < last_prices.size(); ++i) {
+            for (uint32_t n = 0; n < config_.initial_cross_orders; ++n) {
+                addCrossOrder(i, last_prices[i]);
+            }
+        }
+        active_ = true;
+    }
+
+    // Cross-only interest keeps arriving through the window.
+    void accumulate(const std::vector<uint32_t> &last_prices) {
+        uint64_t threshold = Rng::threshold(config_.new_cross_order_probability);
+        for (size_t i = 0; i < cross_only_.size() && i < last_prices.size(); ++i) {
+            if (rng_.next() < threshold) addCrossOrder(i, last_prices[i]);
+        }
+    }
+
+    // Rebuilds the continuous-book view. orders need stock_locate (1-based),
+    // side, price and shares members. One pass buckets orders by symbol, then
+    // each symbol's few price levels are sorted and merged; per-symbol vectors
+    // keep their capacity between calls.
+    template <typename Order>
+    void snapshotBook(const std::vector<Order> &orders, size_t symbol_count) {
+        book_.resize(symbol_count);
+        for (AuctionInterest &interest : book_) interest.clear();
+        for (const Order &order : orders) {
+            if (order.stock_locate == 0 || order.stock_locate > symbol_count) continue;
+            AuctionInterest &interest = book_[order.stock_locate - 1];
+            (order.side == static_cast<char>(Side::Buy) ? interest.buys : interest.sells)
+                .push_back(AuctionLevel{order.price, order.shares});
+        }
+        for (AuctionInterest &interest : book_) {
+            aggregate(interest.buys);
+            aggregate(interest.sells);
+        }
+    }
+
+    AuctionResult compute(size_t symbol_index, uint32_t last_price) {
+        CrossPoint near;
+        return evaluate(symbol_index, last_price, near);
+    }
+
+    // Final cross. Only cross-only (on-open / on-close) interest executes,
+    // priced around the current reference price; resting continuous-book
+    // orders are never touched, so the book a downstream consumer builds from
+    // the adds, executions and deletes stays consistent through the cross.
+    CrossPoint cross(size_t symbol_index, uint32_t last_price) {
+        if (symbol_index >= cross_only_.size() || cross_only_[symbol_index].empty()) {
+            return CrossPoint{};
+        }
+        CrossPoint near;
+        AuctionResult result = evaluate(symbol_index, last_price, near);
+        const AuctionInterest &interest = cross_only_[symbol_index];
+        const AuctionInterest* cross_only[] = {&interest};
+        CrossPoint point = findCrossPoint(cross_only, 1, 0, UINT32_MAX, result.reference_price, scratch_);
+        // Market orders alone offer no candidate price; they pair at the reference.
+        if (point.paired_shares == 0 && interest.market_buy > 0 && interest.market_sell > 0 && result.reference_price > 0) {
+            point = CrossPoint{result.reference_price, std::min(interest.market_buy, interest.market_sell),
+                               interest.market_buy, interest.market_sell};
+        }
+        return point;
+    }
+
+    void end() {
+        active_ = false;
+        cross_only_.clear();
+        book_.clear();
+    }
+
+    bool active() const { return active_; }
+    char crossType() const { return cross_type_; }
+
+    // Saves the window state. The book snapshot is not saved: it is derived
+    // from the live orders and is rebuilt by whoever restores the session.
+    void save(CheckpointWriter &out) const {
+        for (uint64_t word : rng_.state()) out.u64(word);
+        out.u8(active_ ? 1 : 0);
+        out.u8(static_cast<uint8_t>(cross_type_));
+        out.u32(tick_);
+        out.u32(round_lot_);
+        out.u64(cross_only_.size());
+        for (const AuctionInterest &interest : cross_only_) {
+            out.u64(interest.market_buy);
+            out.u64(interest.market_sell);
+            saveLevels(out, interest.buys);
+            saveLevels(out, interest.sells);
+        }
+    }
+
+    void load(CheckpointReader &in) {
+        std::array<uint64_t, 4> state;
+        for (uint64_t &word : state) word = in.u64();
+        rng_.setState(state);
+        active_ = in.u8() != 0;
+        cross_type_ = static_cast<char>(in.u8());
+        tick_ = in.u32();
+        round_lot_ = in.u32();
+        cross_only_.assign(in.count(32), AuctionInterest{});
+        for (AuctionInterest &interest : cross_only_) {
+            interest.market_buy = in.u64();
+            interest.market_sell = in.u64();
+            loadLevels(in, interest.buys);
+            loadLevels(in, interest.sells);
+        }
+        book_.clear();
+    }
+
+private:
+    AuctionResult evaluate(size_t symbol_index, uint32_t last_price, CrossPoint &near) {
+        static const AuctionInterest kNoInterest{};
+        const AuctionInterest &cross = symbol_index < cross_only_.size() ? cross_only_[symbol_index] : kNoInterest;
+        const AuctionInterest &book = symbol_index < book_.size() ? book_[symbol_index] : kNoInterest;
+        AuctionResult result;
+        if (cross.empty() && book.empty()) {
+            return result;
+        }
+
+        // The inside of the continuous book bounds the reference price.
+        uint32_t best_bid = book.buys.empty() ? 0 : book.buys.back().price;
+        uint32_t best_ask = book.sells.empty() ? UINT32_MAX : book.sells.front().price;
+        uint32_t low = std::min(best_bid, best_ask);
+        uint32_t high = std::max(best_bid, best_ask);
+        uint32_t anchor = last_price;
+        if (best_bid > 0 && best_ask != UINT32_MAX) anchor = static_cast<uint32_t>((uint64_t(best_bid) + best_ask) / 2);
+        anchor = std::min(std::max(anchor, low), high);
+
+        const AuctionInterest* both[] = {&cross, &book};
+        CrossPoint reference = findCrossPoint(both, 2, low, high, anchor, scratch_);
+        result.reference_price = reference.price != 0 ? reference.price : anchor;
+
+        near = findCrossPoint(both, 2, 0, UINT32_MAX, result.reference_price, scratch_);
+        const AuctionInterest* cross_only[] = {&cross};
+        CrossPoint far = findCrossPoint(cross_only, 1, 0, UINT32_MAX, result.reference_price, scratch_);
+
+        result.paired_shares = reference.paired_shares;
+        uint64_t buy = reference.buy_shares;
+        uint64_t sell = reference.sell_shares;
+        result.imbalance_shares = buy > sell ? buy - sell : sell - buy;
+        result.imbalance_direction = buy > sell ? 'B' : (sell > buy ? 'S' : 'N');
+        result.near_price = near.paired_shares > 0 ? near.price : 0;
+        result.far_price = far.paired_shares > 0 ? far.price : 0;
+        result.price_variation_indicator = priceVariationIndicator(result.near_price, result.reference_price);
+        return result;
+    }
+
+    uint64_t nextInWindow(uint64_t now, uint64_t start, uint64_t fast_start, uint64_t cross_time) const {
+        if (now >= cross_time) return UINT64_MAX;
+        if (now < start) return start;
+        uint64_t interval = now < fast_start ? config_.slow_interval_ns : config_.fast_interval_ns;
+        uint64_t base = now < fast_start ? start : fast_start;
+        uint64_t next = base + ((now - base) / interval + 1) * interval;
+        if (now < fast_start && next > fast_start) next = fast_start;
+        return next < cross_time ? next : UINT64_MAX;
+    }
+
+    void addCrossOrder(size_t symbol_index, uint32_t last_price) {
+        AuctionInterest &interest = cross_only_[symbol_index];
+        uint64_t shares = uint64_t(round_lot_) * (1 + rng_.below(config_.max_cross_order_lots));
+        bool buy = rng_.next() & 1;
+        // Roughly a third market-on-open/close, the rest limit-on-open/close.
+        if (rng_.below(3) == 0) {
+            (buy ? interest.market_buy : interest.market_sell) += shares;
+            return;
+        }
+        int64_t offset = static_cast<int64_t>(rng_.below(2 * config_.max_cross_offset_ticks + 1)) -
+                         static_cast<int64_t>(config_.max_cross_offset_ticks);
+        int64_t price = static_cast<int64_t>(last_price) + offset * tick_;
+        (buy ? interest.buys : interest.sells).push_back(
+            AuctionLevel{price > 0 ? static_cast<uint32_t>(price) : tick_, shares});
+    }
+
+    static void saveLevels(CheckpointWriter &out, const std::vector<AuctionLevel> &levels) {
+        out.u64(levels.size());
+        for (const AuctionLevel &level : levels) {
+            out.u32(level.price);
+            out.u64(level.shares);
+        }
+    }
+
+    static void loadLevels(CheckpointReader &in, std::vector<AuctionLevel> &levels) {
+        levels.resize(in.count(12));
+        for (AuctionLevel &level : levels) {
+            level.price = in.u32();
+            level.shares = in.u64();
+        }
+    }
+
+    static void aggregate(std::vector<AuctionLevel> &levels) {
+        if (levels.size() < 2) return;
+        std::sort(levels.begin(), levels.end(),
+                  [](const AuctionLevel &a, const AuctionLevel &b) { return a.price < b.price; });
+        size_t out = 0;
+        for (size_t i = 1; i < levels.size(); ++i) {
+            if (levels[i].price == levels[out].price) {
+                levels[out].shares += levels[i].shares;
+            } else {
+                levels[++out] = levels[i];
+            }
+        }
+        levels.resize(out + 1);
+    }
+
+    AuctionConfig config_;
+    Rng rng_;
+    bool active_ = false;
+    char cross_type_ = 'O';
+    uint32_t tick_ = 100;
+    uint32_t round_lot_ = 100;
+    std::vector<AuctionInterest> cross_only_;
+    std::vector<AuctionInterest> book_;
+    CrossScratch scratch_;
+};
@@ -0,0 +1,219 @@
+// Benchmark runner for the message encoders and the pipeline stages.
+//
+//   g++ -std=c++17 -O2 -pthread bench.cpp generator.cpp -o bench
+//   ./bench [--perf] [--iterations N]
+//
+// With --perf each measured section is wrapped in a perf_event_open counter
+// group and results are normalized per message; without it, or where the
+// counters cannot be opened, only wall-clock time is reported.
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include <functional>
+#include <algorithm>
+
+#include "message.hpp"        // ITCH protocol message structs
+#include "constant.hpp"       // ITCH constants
+#include "generator.hpp"      // encoders
+#include "moldudp64.hpp"      // framing stage
+#include "impairment.hpp"     // impairment stage
+#include "session.hpp"        // order flow stage
+#include "stream.hpp"         // streaming output stage
+#include "perf_counters.hpp"  // hardware counters
+
+namespace {
+
+volatile uint64_t g_sink = 0; // Keeps encoder results observable
+
+struct BenchResult {
+    std::string name;
+    uint64_t messages = 0;
+    double ns = 0.0;
+    PerfSample counters;
+};
+
+template <typename Fn>
+BenchResult measure(const std::string &name, uint64_t iterations, PerfCounterGroup &perf, Fn &&fn) {
+    for (uint64_t i = 0; i < iterations / 10 + 1; ++i) {
+        fn(i);
+    }
+    BenchResult result;
+    result.name = name;
+    result.messages = iterations;
+    perf.start();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.counters = perf.stop();
+    result.ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    return result;
+}
+
+void consume(const std::vector<uint8_t> &message) {
+    g_sink = g_sink + message.size() + message[0];
+}
+
+template <typename Fn>
+BenchResult measureEncoder(MessageType type, uint64_t iterations, PerfCounterGroup &perf, Fn &&encode) {
+    return measure(toString(type), iterations, perf, [&](uint64_t i) { consume(encode(i)); });
+}
+
+std::vector<BenchResult> benchEncoders(uint64_t n, PerfCounterGroup &perf) {
+    const std::string stock = "AAPL";
+    std::vector<BenchResult> results;
+    results.push_back(measureEncoder(MessageType::SystemEvent, n, perf, [&](uint64_t i) {
+        return generateSystemEventMessage(1, i, 'O'); }));
+    results.push_back(measureEncoder(MessageType::StockDirectory, n, perf, [&](uint64_t i) {
+        return generateStockDirectoryMessage(1, 1, i, stock, 'Q', 'N', 100, 'N', 'C', "Z", 'P', 'N', 'N', '1', 'N', 0, 'N'); }));
+    results.push_back(measureEncoder(MessageType::StockTradingAction, n, perf, [&](uint64_t i) {
+        return generateStockTradingActionMessage(1, 1, i, stock, 'T', ' ', ""); }));
+    results.push_back(measureEncoder(MessageType::RegSHORestriction, n, perf, [&](uint64_t i) {
+        return generateRegSHORestrictionMessage(1, 1, i, stock, '0'); }));
+    results.push_back(measureEncoder(MessageType::MarketParticipantPosition, n, perf, [&](uint64_t i) {
+        return generateMarketParticipantPositionMessage(1, 1, i, "GSCO", stock, 'Y', 'N', 'A'); }));
+    results.push_back(measureEncoder(MessageType::MWCBStatus, n, perf, [&](uint64_t i) {
+        return generateMWCBStatusMessage(1, i, '1'); }));
+    results.push_back(measureEncoder(MessageType::IPOQuotingPeriodUpdate, n, perf, [&](uint64_t i) {
+        return generateIPOQuotingPeriodUpdateMessage(1, i, stock, 36000, 'A', 1000000); }));
+    results.push_back(measureEncoder(MessageType::LULDAuctionCollar, n, perf, [&](uint64_t i) {
+        return generateLULDAuctionCollarMessage(1, 1, i, stock, 1000000, 1050000, 950000, 0); }));
+    results.push_back(measureEncoder(MessageType::OperationHalt, n, perf, [&](uint64_t i) {
+        return generateOperationalHaltMessage(1, 1, i, stock, 'Q', 'H'); }));
+    results.push_back(measureEncoder(MessageType::AddOrder, n, perf, [&](uint64_t i) {
+        return generateAddOrderMessage(i, i, 'B', 100, stock, 1000000); }));
+    results.push_back(measureEncoder(MessageType::AddOrderWithMPID, n, perf, [&](uint64_t i) {
+        return generateAddOrderWithMPIDMessage(1, 1, i, i, 'S', 100, stock, 1000000, "GSCO"); }));
+    results.push_back(measureEncoder(MessageType::OrderExecuted, n, perf, [&](uint64_t i) {
+        return generateOrderExecutedMessage(1, 1, i, i, 100, i); }));
+    results.push_back(measureEncoder(MessageType::OrderExecutedWithPrice, n, perf, [&](uint64_t i) {
+        return generateOrderExecutedWithPriceMessage(1, 1, i, i, 100, i, 'Y', 1000000); }));
+    results.push_back(measureEncoder(MessageType::OrderCancel, n, perf, [&](uint64_t i) {
+        return generateOrderCancelMessage(1, 1, i, i, 100); }));
+    results.push_back(measureEncoder(MessageType::OrderDelete, n, perf, [&](uint64_t i) {
+        return generateOrderDeleteMessage(1, 1, i, i); }));
+    results.push_back(measureEncoder(MessageType::OrderReplace, n, perf, [&](uint64_t i) {
+        return generateOrderReplaceMessage(1, 1, i, i, i + 1, 100, 1000000); }));
+    results.push_back(measureEncoder(MessageType::Trade, n, perf, [&](uint64_t i) {
+        return generateTradeMessage(1, 1, i, 0, 'B', 100, stock, 1000000, i); }));
+    results.push_back(measureEncoder(MessageType::CrossTrade, n, perf, [&](uint64_t i) {
+        return generateCrossTradeMessage(1, 1, i, 100000, stock, 1000000, i, 'O'); }));
+    results.push_back(measureEncoder(MessageType::BrokenTrade, n, perf, [&](uint64_t i) {
+        return generateBrokenTradeMessage(1, 1, i, i); }));
+    results.push_back(measureEncoder(MessageType::NOII, n, perf, [&](uint64_t i) {
+        return generateNOIIMessage(1, 1, i, 100000, 2000, 'B', stock, 1000000, 1000100, 1000000, 'O', 'L'); }));
+    results.push_back(measureEncoder(MessageType::RPII, n, perf, [&](uint64_t i) {
+        return generateRetailPriceImprovementIndicatorMessage(1, 1, i, stock, 'B'); }));
+    results.push_back(measureEncoder(MessageType::DRWCRPD, n, perf, [&](uint64_t i) {
+        return generateDRWCRPDMessage(1, 1, i, stock, 'Y', 900000, 1100000, 1000000, i, 950000, 1050000); }));
+    return results;
+}
+
+// Pipeline stages, each fed the same pre-generated order flow where it needs input.
+std::vector<BenchResult> benchStages(uint64_t n, PerfCounterGroup &perf) {
+    std::vector<BenchResult> results;
+    std::vector<uint8_t> flow(n * kMaxMessageSize);
+    std::vector<uint16_t> lengths(n);
+
+    {
+        OrderFlowSession session{SessionConfig{}};
+        results.push_back(measure("session: generate", n, perf, [&](uint64_t i) {
+            size_t length = session.next(flow.data() + i * kMaxMessageSize);
+            lengths[i] = static_cast<uint16_t>(length);
+        }));
+    }
+    {
+        MoldPacketBuilder packet(makeMoldSession("BENCH"));
+        results.push_back(measure("moldudp64: frame", n, perf, [&](uint64_t i) {
+            const uint8_t* message = flow.data() + i * kMaxMessageSize;
+            if (!packet.append(message, lengths[i])) {
+                g_sink = g_sink + packet.finish();
+                packet.reset();
+                packet.append(message, lengths[i]);
+            }
+        }));
+    }
+    {
+        Impairment impairment;
+        results.push_back(measure("impairment: passthrough", n, perf, [&](uint64_t i) {
+            impairment.process(flow.data() + i * kMaxMessageSize, lengths[i],
+                               [](const uint8_t* data, size_t length) { g_sink = g_sink + data[0] + length; });
+        }));
+    }
+    {
+        StreamConfig config;
+        config.memory_budget = 16u << 20;
+        config.report_interval = std::chrono::milliseconds(0);
+        StreamWriter writer(config, [](const uint8_t* data, size_t size) { g_sink = g_sink + data[0] + size; });
+        results.push_back(measure("stream: append", n, perf, [&](uint64_t i) {
+            writer.append(flow.data() + i * kMaxMessageSize, lengths[i]);
+        }));
+    }
+    return results;
+}
+
+void printResults(const std::string &title, const std::vector<BenchResult> &results, const PerfCounterGroup &perf) {
+    std::cout << "\n" << title << "\n";
+    std::cout << std::left << std::setw(52) << "name" << std::right << std::setw(10) << "ns/msg";
+    if (perf.available()) {
+        std::cout << std::setw(10) << "cyc/msg" << std::setw(8) << "IPC";
+        for (PerfEvent event : {PerfEvent::L1DMisses, PerfEvent::LLCMisses, PerfEvent::BranchMisses, PerfEvent::StoreForwardStalls}) {
+            if (perf.has(event)) std::cout << std::setw(18) << toString(event);
+        }
+    }
+    std::cout << "\n";
+
+    std::cout << std::fixed;
+    for (const BenchResult &result : results) {
+        double n = static_cast<double>(result.messages);
+        std::cout << std::left << std::setw(52) << result.name << std::right
+                  << std::setw(10) << std::setprecision(2) << result.ns / n;
+        if (perf.available()) {
+            const PerfSample &c = result.counters;
+            double cycles = static_cast<double>(c[PerfEvent::Cycles]);
+            std::cout << std::setw(10) << std::setprecision(1) << cycles / n
+                      << std::setw(8) << std::setprecision(2)
+                      << (cycles > 0 ? static_cast<double>(c[PerfEvent::Instructions]) / cycles : 0.0);
+            for (PerfEvent event : {PerfEvent::L1DMisses, PerfEvent::LLCMisses, PerfEvent::BranchMisses, PerfEvent::StoreForwardStalls}) {
+                if (perf.has(event)) {
+                    std::cout << std::setw(18) << std::setprecision(4) << static_cast<double>(c[event]) / n;
+                }
+            }
+        }
+        std::cout << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t iterations = 1'000'000;
+    bool use_perf = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--perf") {
+            use_perf = true;
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--perf] [--iterations N]\n";
+            return 1;
+        }
+    }
+
+    PerfCounterGroup perf;
+    if (use_perf && !perf.open()) {
+        std::cerr << "perf_event_open unavailable; reporting wall-clock time only\n";
+    }
+
+    printResults("Encoders (per MessageType)", benchEncoders(iterations, perf), perf);
+    printResults("Pipeline stages", benchStages(iterations, perf), perf);
+    std::cout << "\nchecksum " << g_sink << "\n";
+    return 0;
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compact binary checkpoint encoding. Values are written little-endian in the
+// order they are saved; a header identifies the format and a trailing
+// FNV-1a checksum guards against truncated or corrupted files. Components
+// provide save(CheckpointWriter&) / load(CheckpointReader&) pairs that must
+// mirror each other field for field. Other file formats (e.g. workload
+// profiles) reuse the encoding under their own magic and version.
+
+constexpr uint64_t kCheckpointMagic = 0x54504B4348435449ULL; // "ITCHCKPT"
+constexpr uint32_t kCheckpointVersion = 2;
+
+inline uint64_t fnv1a64(const uint8_t* data, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(uint64_t magic = kCheckpointMagic, uint32_t version = kCheckpointVersion) {
+        u64(magic);
+        u32(version);
+    }
+
+    void u8(uint8_t value) { buffer_.push_back(value); }
+    void u16(uint16_t value) { put(value, 2); }
+    void u32(uint32_t value) { put(value, 4); }
+    void u64(uint64_t value) { put(value, 8); }
+
+    void f64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u64(bits);
+    }
+
+    void str(const std::string &value) {
+        u32(static_cast<uint32_t>(value.size()));
+        bytes(value.data(), value.size());
+    }
+
+    void bytes(const void* data, size_t size) {
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        buffer_.insert(buffer_.end(), begin, begin + size);
+    }
+
+    // Reserves room up front for bulk sections such as the live order set.
+    void reserve(size_t additional) { buffer_.reserve(buffer_.size() + additional); }
+
+    // Writes to path via a temporary file and rename, so a crash mid-write
+    // never leaves a half-written checkpoint under the final name.
+    void writeFile(const std::string &path) {
+        uint64_t checksum = fnv1a64(buffer_.data(), buffer_.size());
+        std::string temp = path + ".tmp";
+        FILE* file = std::fopen(temp.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("checkpoint: cannot create " + temp);
+        }
+        uint8_t trailer[8];
+        for (int i = 0; i < 8; ++i) trailer[i] = static_cast<uint8_t>(checksum >> (8 * i));
+        bool ok = std::fwrite(buffer_.data(), 1, buffer_.size(), file) == buffer_.size() &&
+                  std::fwrite(trailer, 1, sizeof(trailer), file) == sizeof(trailer);
+        ok = (std::fclose(file) == 0) && ok;
+        if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            throw std::runtime_error("checkpoint: failed writing " + path);
+        }
+    }
+
+    size_t size() const { return buffer_.size(); }
+
+private:
+    void put(uint64_t value, int size) {
+        for (int i = 0; i < size; ++i) {
+            buffer_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    std::vector<uint8_t> buffer_;
+};
+
+class CheckpointReader {
+public:
+    explicit CheckpointReader(const std::string &path, uint64_t magic = kCheckpointMagic,
+                              uint32_t version = kCheckpointVersion) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            throw std::runtime_error("checkpoint: cannot open " + path);
+        }
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if (size < 20) {
+            std::fclose(file);
+            throw std::runtime_error("checkpoint: " + path + " is truncated");
+        }
+        buffer_.resize(static_cast<size_t>(size));
+        size_t read = std::fread(buffer_.data(), 1, buffer_.size(), file);
+        std::fclose(file);
+        if (read != buffer_.size()) {
+            throw std::runtime_error("checkpoint: short read on " + path);
+        }
+
+        end_ = buffer_.size() - 8;
+        uint64_t stored = 0;
+        for (int i = 0; i < 8; ++i) stored |= static_cast<uint64_t>(buffer_[end_ + i]) << (8 * i);
+        if (fnv1a64(buffer_.data(), end_) != stored) {
+            throw std::runtime_error("checkpoint: checksum mismatch in " + path);
+        }
+        if (u64() != magic || u32() != version) {
+            throw std::runtime_error("checkpoint: " + path + " has an unsupported format or version");
+        }
+    }
+
+    uint8_t u8() { need(1); return buffer_[offset_++]; }
+    uint16_t u16() { return static_cast<uint16_t>(get(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(get(4)); }
+    uint64_t u64() { return get(8); }
+
+    double f64() {
+        uint64_t bits = u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string str() {
+        uint32_t size = u32();
+        need(size);
+        std::string value(reinterpret_cast<const char*>(buffer_.data() + offset_), size);
+        offset_ += size;
+        return value;
+    }
+
+    void bytes(void* out, size_t size) {
+        need(size);
+        std::memcpy(out, buffer_.data() + offset_, size);
+        offset_ += size;
+    }
+
+    // Element counts read back from the file are checked against what is
+    // left before anything is allocated for them.
+    size_t count(size_t bytes_per_element) {
+        uint64_t n = u64();
+        if (bytes_per_element > 0 && n > (end_ - offset_) / bytes_per_element) {
+            throw std::runtime_error("checkpoint: corrupt element count");
+        }
+        return static_cast<size_t>(n);
+    }
+
+    bool atEnd() const { return offset_ == end_; }
+
+private:
+    void need(size_t size) {
+        if (size > end_ - offset_) {
+            throw std::runtime_error("checkpoint: unexpected end of data");
+        }
+    }
+
+    uint64_t get(int size) {
+        need(static_cast<size_t>(size));
+        uint64_t value = 0;
+        for (int i = 0; i < size; ++i) {
+            value |= static_cast<uint64_t>(buffer_[offset_++]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::vector<uint8_t> buffer_;
+    size_t offset_ = 0;
+    size_t end_ = 0;
+};
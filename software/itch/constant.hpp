@@ -1,5 +1,7 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <array>
 #include <string_view>
 #include <string>
 
@@ -30,6 +32,33 @@ enum class MessageType : uint8_t {
     DRWCRPD = 'O', 
 };
 
+constexpr size_t kMessageTypeCount = 23;
+
+constexpr std::array<MessageType, kMessageTypeCount> kMessageTypes = {
+    MessageType::SystemEvent, MessageType::StockDirectory, MessageType::StockTradingAction,
+    MessageType::RegSHORestriction, MessageType::MarketParticipantPosition, MessageType::MWCBDeclineLevel,
+    MessageType::MWCBStatus, MessageType::IPOQuotingPeriodUpdate, MessageType::LULDAuctionCollar,
+    MessageType::OperationHalt, MessageType::AddOrder, MessageType::AddOrderWithMPID,
+    MessageType::OrderExecuted, MessageType::OrderExecutedWithPrice, MessageType::OrderCancel,
+    MessageType::OrderDelete, MessageType::OrderReplace, MessageType::Trade,
+    MessageType::CrossTrade, MessageType::BrokenTrade, MessageType::NOII,
+    MessageType::RPII, MessageType::DRWCRPD,
+};
+
+// Dense index into kMessageTypes for per-type tables; -1 for a byte that is
+// not an ITCH 5.0 message type.
+inline int messageTypeIndex(uint8_t code) {
+    static const std::array<int8_t, 256> table = [] {
+        std::array<int8_t, 256> t{};
+        t.fill(-1);
+        for (size_t i = 0; i < kMessageTypeCount; ++i) {
+            t[static_cast<uint8_t>(kMessageTypes[i])] = static_cast<int8_t>(i);
+        }
+        return t;
+    }();
+    return table[code];
+}
+
 enum class SystemEventCode : uint8_t {
     StartOfMessages = 'O', // Outside of time stamp messages, the start of day message is the first message sent in any trading day.
     StartOfSystem = 'S', // This message indicates that NASDAQ is open and ready to start accepting orders.
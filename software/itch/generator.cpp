@@ -10,23 +10,7 @@
 
 #include "message.hpp" // ITCH protocol message struct 
 #include "constant.hpp" // ITCH constants
-
-// Helper function: packs a 64-bit timestamp (with only the lower 48 bits valid)
-// into a std::array<char, 6> in big-endian order
-void packTimestamp(std::array<char, 6>& dest, uint64_t timestamp) {
-    for (int i = 0; i < 6; ++i) {
-        dest[i] = static_cast<char>((timestamp >> (8 * (5 - i))) & 0xFF);
-    }
-}
-
-// Helper template to pack a string into a fixed-size std::array<char, N>
-// Padding with spaces if needed.
-template <size_t N>
-void packString(std::array<char, N>& dest, const std::string &s) {
-    std::fill(dest.begin(), dest.end(), ' ');
-    size_t len = std::min(s.size(), static_cast<size_t>(N));
-    std::copy_n(s.begin(), len, dest.begin());
-}
+#include "generator.hpp" // encoder declarations and packing helpers
 
 
 // SystemEventMessage
@@ -0,0 +1,249 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <array>
+#include <algorithm>
+
+// Helper function: packs a 64-bit timestamp (with only the lower 48 bits valid)
+// into a std::array<char, 6> in big-endian order
+inline void packTimestamp(std::array<char, 6>& dest, uint64_t timestamp) {
+    for (int i = 0; i < 6; ++i) {
+        dest[i] = static_cast<char>((timestamp >> (8 * (5 - i))) & 0xFF);
+    }
+}
+
+// Helper template to pack a string into a fixed-size std::array<char, N>
+// Padding with spaces if needed.
+template <size_t N>
+void packString(std::array<char, N>& dest, const std::string &s) {
+    std::fill(dest.begin(), dest.end(), ' ');
+    size_t len = std::min(s.size(), static_cast<size_t>(N));
+    std::copy_n(s.begin(), len, dest.begin());
+}
+
+// Message encoders implemented in generator.cpp. Each returns one ITCH message
+// laid out exactly as the packed struct in message.hpp.
+
+std::vector<uint8_t> generateSystemEventMessage(
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    char event_code
+);
+
+std::vector<uint8_t> generateStockDirectoryMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    char market_category,
+    char financial_status_indicator,
+    uint32_t round_lot_size,
+    char round_lots_only,
+    char issue_classification,
+    const std::string &issue_subtype,
+    char authenticity,
+    char short_sale_threshold_indicator,
+    char ipo_flag,
+    char LULDReference_price_tier,
+    char etp_flag,
+    uint32_t etp_leverage_factor,
+    char inverse_indicator
+);
+
+std::vector<uint8_t> generateStockTradingActionMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    char trading_state,
+    char reserved,
+    const std::string &action_reason
+);
+
+std::vector<uint8_t> generateRegSHORestrictionMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    char reg_sho_action
+);
+
+std::vector<uint8_t> generateMarketParticipantPositionMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &mpid,
+    const std::string &stock,
+    char primary_market_maker,
+    char market_maker_mode,
+    char market_participant_state
+);
+
+std::vector<uint8_t> generateMWCBStatusMessage(
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    char breached_level
+);
+
+std::vector<uint8_t> generateIPOQuotingPeriodUpdateMessage(
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    uint32_t ipo_quotation_release_time,
+    char ipo_quotation_release_qualifier,
+    uint32_t ipo_price
+);
+
+std::vector<uint8_t> generateLULDAuctionCollarMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    uint32_t auction_collar_ref_price,
+    uint32_t upper_auction_collar_price,
+    uint32_t lower_auction_collar_price,
+    uint32_t auction_collar_extension
+);
+
+std::vector<uint8_t> generateOperationalHaltMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    char market_code,
+    char operational_halt_action
+);
+
+std::vector<uint8_t> generateAddOrderMessage(
+    uint64_t timestamp,
+    uint64_t orderRef,
+    uint8_t side,
+    uint32_t shares,
+    const std::string &stock,
+    uint32_t price
+);
+
+std::vector<uint8_t> generateAddOrderWithMPIDMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t orderRef,
+    uint8_t side,
+    uint32_t shares,
+    const std::string &stock,
+    uint32_t price,
+    const std::string &attribution
+);
+
+std::vector<uint8_t> generateOrderExecutedMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t orderRef,
+    uint32_t executed_shares,
+    uint64_t match_number
+);
+
+std::vector<uint8_t> generateOrderExecutedWithPriceMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t orderRef,
+    uint32_t executed_shares,
+    uint64_t match_number,
+    char printable,
+    uint32_t execution_price
+);
+
+std::vector<uint8_t> generateOrderCancelMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t orderRef,
+    uint32_t cancelled_shares
+);
+
+std::vector<uint8_t> generateOrderDeleteMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t orderRef
+);
+
+std::vector<uint8_t> generateOrderReplaceMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t original_order_ref,
+    uint64_t new_order_ref,
+    uint32_t shares,
+    uint32_t price
+);
+
+std::vector<uint8_t> generateTradeMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t orderRef,
+    uint8_t side,
+    uint32_t shares,
+    const std::string &stock,
+    uint32_t price,
+    uint64_t match_number
+);
+
+std::vector<uint8_t> generateCrossTradeMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t shares,
+    const std::string &stock,
+    uint32_t cross_price,
+    uint64_t match_number,
+    char cross_type
+);
+
+std::vector<uint8_t> generateBrokenTradeMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t match_number
+);
+
+std::vector<uint8_t> generateNOIIMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    uint64_t paired_shares,
+    uint64_t imbalance_shares,
+    char imbalance_direction,
+    const std::string &stock,
+    uint32_t far_price,
+    uint32_t near_price,
+    uint32_t current_reference_price,
+    char cross_type,
+    char price_variation_indicator
+);
+
+std::vector<uint8_t> generateRetailPriceImprovementIndicatorMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    char interest_flag
+);
+
+std::vector<uint8_t> generateDRWCRPDMessage(
+    uint16_t stock_locate,
+    uint16_t tracking_number,
+    uint64_t timestamp,
+    const std::string &stock,
+    char open_eligibility_status,
+    uint32_t min_allowable_price,
+    uint32_t max_allowable_price,
+    uint32_t near_execution_price,
+    uint64_t near_execution_time,
+    uint32_t lower_price_collar,
+    uint32_t upper_price_collar
+);
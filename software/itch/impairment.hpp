@@ -0,0 +1,189 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include "rng.hpp" // deterministic random source
+
+// Fault injection between framing and output. A "unit" is whatever the caller
+// feeds in: a single ITCH message or a whole MoldUDP64 packet.
+struct ImpairmentConfig {
+    double drop_probability = 0.0;       // Start a drop burst
+    double duplicate_probability = 0.0;  // Emit the unit twice
+    double reorder_probability = 0.0;    // Emit the unit after the next reorder_depth units
+    double delay_probability = 0.0;      // Emit the unit after the next delay_units units
+    double truncate_probability = 0.0;   // Emit only a random non-empty prefix of the unit
+    uint32_t drop_burst_length = 1;      // Units lost per drop event, including the first
+    uint32_t reorder_depth = 1;
+    uint32_t delay_units = 64;
+    uint64_t seed = 1;
+
+    bool enabled() const {
+        return drop_probability > 0.0 || duplicate_probability > 0.0 || reorder_probability > 0.0 ||
+               delay_probability > 0.0 || truncate_probability > 0.0;
+    }
+};
+
+struct ImpairmentStats {
+    uint64_t units_in = 0;
+    uint64_t units_out = 0;
+    uint64_t dropped = 0;
+    uint64_t duplicated = 0;
+    uint64_t reordered = 0;
+    uint64_t delayed = 0;
+    uint64_t truncated = 0;
+};
+
+// Applies ImpairmentConfig to a stream of units and hands the result to a sink
+// callable as sink(const uint8_t* data, size_t length). With every probability
+// at zero process() is a single predictable branch in front of the sink call,
+// and no statistics are kept.
+class Impairment {
+public:
+    explicit Impairment(const ImpairmentConfig &config = ImpairmentConfig{})
+        : config_(config), rng_(config.seed) {
+        active_ = config.enabled();
+        drop_threshold_ = Rng::threshold(config.drop_probability);
+        duplicate_threshold_ = Rng::threshold(config.duplicate_probability);
+        reorder_threshold_ = Rng::threshold(config.reorder_probability);
+        delay_threshold_ = Rng::threshold(config.delay_probability);
+        truncate_threshold_ = Rng::threshold(config.truncate_probability);
+    }
+
+    template <typename Sink>
+    void process(const uint8_t* data, size_t length, Sink &&sink) {
+        if (__builtin_expect(!active_, 1)) {
+            sink(data, length);
+            return;
+        }
+        processImpaired(data, length, sink);
+    }
+
+    // Releases every held (reordered or delayed) unit in the order it was due,
+    // as if enough further units had gone past. Call at end of stream: held
+    // units otherwise only move when another unit reaches process().
+    template <typename Sink>
+    void drain(Sink &&sink) {
+        std::vector<Held*> due;
+        for (Held &held : held_) {
+            if (held.in_use) due.push_back(&held);
+        }
+        std::sort(due.begin(), due.end(), [](const Held* a, const Held* b) {
+            return a->release_after != b->release_after ? a->release_after < b->release_after : a->order < b->order;
+        });
+        for (Held* held : due) {
+            emit(held->bytes.data(), held->bytes.size(), sink);
+            held->in_use = false;
+        }
+        held_count_ = 0;
+    }
+
+    size_t held() const { return held_count_; }
+
+    const ImpairmentStats &stats() const { return stats_; }
+    const ImpairmentConfig &config() const { return config_; }
+    bool active() const { return active_; }
+
+private:
+    struct Held {
+        std::vector<uint8_t> bytes;
+        uint32_t release_after = 0;   // Units still to pass before this one is emitted
+        uint64_t order = 0;           // Hold order, breaks ties in drain()
+        bool in_use = false;
+    };
+
+    template <typename Sink>
+    void emit(const uint8_t* data, size_t length, Sink &sink) {
+        ++stats_.units_out;
+        sink(data, length);
+    }
+
+    template <typename Sink>
+    void processImpaired(const uint8_t* data, size_t length, Sink &sink) {
+        ++stats_.units_in;
+
+        if (burst_remaining_ > 0) {
+            --burst_remaining_;
+            ++stats_.dropped;
+            tick(sink);
+            return;
+        }
+        if (rng_.next() < drop_threshold_) {
+            burst_remaining_ = config_.drop_burst_length > 0 ? config_.drop_burst_length - 1 : 0;
+            ++stats_.dropped;
+            tick(sink);
+            return;
+        }
+
+        if (length > 1 && rng_.next() < truncate_threshold_) {
+            length = 1 + rng_.below(length - 1);
+            ++stats_.truncated;
+        }
+
+        if (rng_.next() < reorder_threshold_) {
+            hold(data, length, config_.reorder_depth);
+            ++stats_.reordered;
+            return;
+        }
+        if (rng_.next() < delay_threshold_) {
+            hold(data, length, config_.delay_units);
+            ++stats_.delayed;
+            return;
+        }
+
+        emit(data, length, sink);
+        if (rng_.next() < duplicate_threshold_) {
+            emit(data, length, sink);
+            ++stats_.duplicated;
+        }
+        tick(sink);
+    }
+
+    void hold(const uint8_t* data, size_t length, uint32_t release_after) {
+        Held* slot = nullptr;
+        for (Held &held : held_) {
+            if (!held.in_use) {
+                slot = &held;
+                break;
+            }
+        }
+        if (slot == nullptr) {
+            held_.emplace_back();
+            slot = &held_.back();
+        }
+        slot->bytes.assign(data, data + length);
+        slot->release_after = release_after > 0 ? release_after : 1;
+        slot->order = stats_.reordered + stats_.delayed;
+        slot->in_use = true;
+        ++held_count_;
+    }
+
+    // One more unit has gone past; release held units whose turn has come.
+    template <typename Sink>
+    void tick(Sink &sink) {
+        if (held_count_ == 0) {
+            return;
+        }
+        for (Held &held : held_) {
+            if (held.in_use && --held.release_after == 0) {
+                emit(held.bytes.data(), held.bytes.size(), sink);
+                held.in_use = false;
+                --held_count_;
+            }
+        }
+    }
+
+    ImpairmentConfig config_;
+    Rng rng_;
+    bool active_ = false;
+    uint64_t drop_threshold_ = 0;
+    uint64_t duplicate_threshold_ = 0;
+    uint64_t reorder_threshold_ = 0;
+    uint64_t delay_threshold_ = 0;
+    uint64_t truncate_threshold_ = 0;
+    uint32_t burst_remaining_ = 0;
+    size_t held_count_ = 0;
+    std::vector<Held> held_;
+    ImpairmentStats stats_;
+};
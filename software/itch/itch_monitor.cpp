@@ -0,0 +1,126 @@
+// Attaches to a running generator's metrics page and prints rates.
+//
+//   g++ -std=c++17 -O2 itch_monitor.cpp -o itch_monitor
+//   ./itch_monitor [name] [--interval-ms N] [--count N]
+//
+// name is the MetricsPublisher's shm name (default itch-metrics). One line is
+// printed per interval until the publisher goes away or --count lines have
+// been printed; a publisher that is alive but no longer refreshing the page
+// is reported as stalled.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+
+#include <signal.h>
+
+#include "constant.hpp" // ITCH constants
+#include "metrics.hpp"  // metrics page
+
+namespace {
+
+std::string clockString(uint64_t ns_since_midnight) {
+    uint64_t ms = ns_since_midnight / 1'000'000;
+    std::ostringstream out;
+    out << std::setfill('0') << std::setw(2) << ms / 3'600'000 << ":" << std::setw(2) << ms / 60'000 % 60 << ":"
+        << std::setw(2) << ms / 1000 % 60 << "." << std::setw(3) << ms % 1000;
+    return out.str();
+}
+
+std::string rateString(double per_second) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(per_second >= 1e6 ? 2 : 0);
+    if (per_second >= 1e6) {
+        out << per_second / 1e6 << "M";
+    } else {
+        out << per_second;
+    }
+    return out.str();
+}
+
+bool publisherAlive(const MetricsReader &reader, uint32_t pid) {
+    if (reader.detached()) return false;
+    return pid == 0 || ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+void printLine(const MetricsSnapshot &now, const MetricsSnapshot &before) {
+    double seconds = static_cast<double>(now.wall_ns - before.wall_ns) * 1e-9;
+    if (seconds <= 0.0) seconds = 1.0;
+    double messages = static_cast<double>(now.messages - before.messages) / seconds;
+    double megabytes = static_cast<double>(now.bytes - before.bytes) / seconds / 1e6;
+
+    std::cout << clockString(now.simulated_ns) << "  " << std::setw(9) << rateString(messages) << " msg/s  "
+              << std::fixed << std::setprecision(1) << std::setw(7) << megabytes << " MB/s  live "
+              << std::setw(9) << now.live_orders;
+    for (uint32_t i = 0; i < now.stage_count && i < kMetricsMaxStages; ++i) {
+        const MetricsStage &stage = now.stages[i];
+        std::cout << "  " << stage.name << " " << stage.depth;
+        if (stage.capacity > 0) std::cout << "/" << stage.capacity;
+    }
+
+    // Busiest message types over the interval.
+    std::vector<std::pair<uint64_t, size_t>> deltas;
+    for (size_t t = 0; t < kMessageTypeCount; ++t) {
+        uint64_t delta = now.by_type[t] - before.by_type[t];
+        if (delta > 0) deltas.emplace_back(delta, t);
+    }
+    std::sort(deltas.rbegin(), deltas.rend());
+    std::cout << "  |";
+    for (size_t i = 0; i < deltas.size() && i < 6; ++i) {
+        std::cout << " " << static_cast<char>(kMessageTypes[deltas[i].second]) << " "
+                  << rateString(static_cast<double>(deltas[i].first) / seconds);
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string name = "itch-metrics";
+    std::chrono::milliseconds interval(1000);
+    uint64_t count = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--interval-ms" && i + 1 < argc) {
+            interval = std::chrono::milliseconds(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--count" && i + 1 < argc) {
+            count = std::stoull(argv[++i]);
+        } else if (arg.rfind("--", 0) != 0) {
+            name = arg;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [name] [--interval-ms N] [--count N]\n";
+            return 1;
+        }
+    }
+
+    try {
+        MetricsReader reader(name);
+        MetricsSnapshot before{};
+        MetricsSnapshot now{};
+        if (!reader.read(before)) {
+            std::cerr << "metrics page is not settling\n";
+            return 1;
+        }
+        for (uint64_t lines = 0; count == 0 || lines < count; ++lines) {
+            std::this_thread::sleep_for(interval);
+            if (!reader.read(now)) continue;
+            if (now.publish_count == before.publish_count) {
+                if (!publisherAlive(reader, now.pid)) break;
+                std::cout << clockString(now.simulated_ns) << "  stalled" << std::endl;
+                continue;
+            }
+            printLine(now, before);
+            before = now;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Builds a workload profile from a real ITCH 5.0 BinaryFILE capture, for
+// OrderFlowSession to sample from (SessionConfig::profile).
+//
+//   g++ -std=c++17 -O2 -pthread itch_profile.cpp -o itch_profile
+//   ./itch_profile <capture> <profile> [--threads N] [--bucket-seconds S] [--top N]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "constant.hpp"  // ITCH constants
+#include "profile.hpp"   // workload profile
+#include "profiler.hpp"  // capture pass
+
+namespace {
+
+void printSummary(const WorkloadProfile &profile, const ProfilerStats &stats, size_t top) {
+    double gb = static_cast<double>(stats.bytes) / 1e9;
+    std::cout << std::fixed << std::setprecision(2)
+              << stats.messages << " messages, " << gb << " GB in " << stats.seconds << " s on "
+              << stats.threads << " threads (" << (stats.seconds > 0 ? gb / stats.seconds : 0.0) << " GB/s)";
+    if (stats.unknown > 0) std::cout << ", " << stats.unknown << " unrecognized";
+    std::cout << "\n\nmessage type mix\n";
+
+    WorkloadProfile::TypeCounts totals{};
+    for (const WorkloadProfile::TypeCounts &counts : profile.type_mix) {
+        for (size_t t = 0; t < kMessageTypeCount; ++t) totals[t] += counts[t];
+    }
+    for (size_t t = 0; t < kMessageTypeCount; ++t) {
+        if (totals[t] == 0) continue;
+        std::cout << "  " << std::left << std::setw(52) << toString(kMessageTypes[t]) << std::right
+                  << std::setw(14) << totals[t] << std::setw(8) << std::setprecision(2)
+                  << 100.0 * static_cast<double>(totals[t]) / static_cast<double>(std::max<uint64_t>(profile.messages, 1))
+                  << "%\n";
+    }
+
+    std::cout << "\nbusiest symbols" << std::setw(49) << "adds" << std::setw(10) << "exec/add" << std::setw(10) << "cxl/add\n";
+    for (const std::string &name : profile.busiestSymbols(top)) {
+        for (const SymbolProfile &symbol : profile.symbols) {
+            if (symbol.stock != name) continue;
+            std::cout << "  " << std::left << std::setw(48) << name << std::right << std::setw(14) << symbol.adds
+                      << std::setw(10) << std::setprecision(3) << symbol.executeRatio()
+                      << std::setw(10) << symbol.cancelRatio() << "\n";
+            break;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ProfilerOptions options;
+    size_t top = 10;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--bucket-seconds" && i + 1 < argc) {
+            options.bucket_ns = std::max<uint64_t>(1, std::stoull(argv[++i])) * 1'000'000'000ULL;
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = std::stoul(argv[++i]);
+        } else if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+        } else {
+            paths.clear();
+            break;
+        }
+    }
+    if (paths.size() != 2) {
+        std::cerr << "usage: " << argv[0] << " <capture> <profile> [--threads N] [--bucket-seconds S] [--top N]\n";
+        return 1;
+    }
+
+    try {
+        ProfilerStats stats;
+        WorkloadProfile profile = CaptureProfiler(options).run(paths[0], &stats);
+        profile.saveFile(paths[1]);
+        printSummary(profile, stats, top);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Streams the synthetic feed to a BinaryFILE within a fixed memory budget.
+//
+//   g++ -std=c++17 -O2 -pthread itch_stream.cpp generator.cpp -o itch_stream
+//   ./itch_stream <output|-> [--messages N] [--days D] [--memory-budget MB] [--chunk-size KB]
+//                 [--interarrival-ns N] [--seed S] [--report-ms N] [--metrics NAME]
+//
+// Messages are framed BinaryFILE style (2 byte big-endian length, then the
+// message) into a pool of --memory-budget MB of --chunk-size KB chunks and
+// written by a background thread; a slow disk stalls the generator instead
+// of growing the process. --days runs that many trading days back to back,
+// each a fresh session seeded seed + day, so every day opens with its own
+// start of messages event. --messages caps the total across days (0, the
+// default, runs every day to its end). With --metrics the live counters and
+// the depth of the chunk queue are published for itch_monitor.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "constant.hpp"  // ITCH constants
+#include "session.hpp"   // order flow
+#include "stream.hpp"    // bounded-memory writer
+#include "metrics.hpp"   // live metrics page
+
+namespace {
+
+struct Options {
+    std::string path;
+    uint64_t messages = 0;
+    uint32_t days = 1;
+    StreamConfig stream;
+    SessionConfig session;
+    std::string metrics_name;
+};
+
+// Sink on the writer thread: it cannot throw, so a failed write is recorded
+// and the rest of the stream is discarded.
+class FileSink {
+public:
+    explicit FileSink(int fd) : fd_(fd) {}
+
+    void operator()(const uint8_t* data, size_t size) {
+        while (size > 0 && !failed_.load(std::memory_order_relaxed)) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error_ = errno;
+                failed_.store(true, std::memory_order_relaxed);
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    bool failed() const { return failed_.load(std::memory_order_relaxed); }
+    int error() const { return error_; }
+
+private:
+    int fd_;
+    int error_ = 0;
+    std::atomic<bool> failed_{false};
+};
+
+int run(const Options &options) {
+    bool to_stdout = options.path == "-";
+    int fd = to_stdout ? STDOUT_FILENO : ::open(options.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "cannot create " << options.path << "\n";
+        return 1;
+    }
+    FileSink sink(fd);
+    std::unique_ptr<MetricsPublisher> metrics;
+    if (!options.metrics_name.empty()) metrics = std::make_unique<MetricsPublisher>(options.metrics_name);
+
+    auto start = std::chrono::steady_clock::now();
+    StreamWriter writer(options.stream, [&sink](const uint8_t* data, size_t size) { sink(data, size); });
+    uint64_t remaining = options.messages == 0 ? UINT64_MAX : options.messages;
+    // Reports go to stderr so that "-" leaves stdout to the stream.
+    std::ostream &report = to_stdout ? std::cerr : std::cout;
+    report << std::fixed << std::setprecision(2);
+    for (uint32_t day = 0; day < options.days && remaining > 0 && !sink.failed(); ++day) {
+        SessionConfig config = options.session;
+        config.seed = options.session.seed + day;
+        OrderFlowSession session(config);
+        uint64_t written = streamSession(session, writer, remaining, metrics.get());
+        bool complete = written < remaining;   // The session ran out before the cap did
+        remaining -= written;
+        report << "day " << day + 1 << ": " << written << " messages, seed " << config.seed << ", "
+               << (complete ? "complete" : "cut short") << "\n";
+    }
+    writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!to_stdout) ::close(fd);
+    if (sink.failed()) {
+        std::cerr << "write to " << options.path << " failed: " << std::strerror(sink.error()) << "\n";
+        return 1;
+    }
+
+    StreamStats stats = writer.stats();
+    report << "stream: " << stats.messages << " messages, " << stats.bytes << " bytes in " << seconds << " s, "
+           << stats.messages / seconds / 1e6 << " M msg/s, " << stats.bytes / seconds / 1e6 << " MB/s\n"
+           << "  " << std::left << std::setw(52) << "chunks written" << std::right << std::setw(14) << stats.chunks_written << "\n"
+           << "  " << std::left << std::setw(52) << "chunk pool (chunks)" << std::right << std::setw(14) << stats.pool_chunks << "\n"
+           << "  " << std::left << std::setw(52) << "producer stalls on a full pool" << std::right << std::setw(14) << stats.producer_stalls << "\n"
+           << "  " << std::left << std::setw(52) << "time stalled (ms)" << std::right << std::setw(14) << stats.stall_ns / 1e6 << "\n"
+           << "  " << std::left << std::setw(52) << "resident set at end (MB)" << std::right << std::setw(14)
+           << static_cast<double>(stats.rss_bytes) / (1 << 20) << "\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--messages" && i + 1 < argc) {
+            options.messages = std::stoull(argv[++i]);
+        } else if (arg == "--days" && i + 1 < argc) {
+            options.days = static_cast<uint32_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            options.stream.memory_budget = std::stoull(argv[++i]) << 20;
+        } else if (arg == "--chunk-size" && i + 1 < argc) {
+            options.stream.chunk_size = std::stoull(argv[++i]) << 10;
+        } else if (arg == "--interarrival-ns" && i + 1 < argc) {
+            options.session.mean_interarrival_ns = std::stod(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.session.seed = std::stoull(argv[++i]);
+        } else if (arg == "--report-ms" && i + 1 < argc) {
+            options.stream.report_interval = std::chrono::milliseconds(std::stoull(argv[++i]));
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            options.metrics_name = argv[++i];
+        } else if (options.path.empty() && (arg == "-" || arg.rfind("--", 0) != 0)) {
+            options.path = arg;
+        } else {
+            options.path.clear();
+            break;
+        }
+    }
+    if (options.path.empty()) {
+        std::cerr << "usage: " << argv[0] << " <output|-> [--messages N] [--days D] [--memory-budget MB]"
+                  << " [--chunk-size KB] [--interarrival-ns N] [--seed S] [--report-ms N] [--metrics NAME]\n";
+        return 1;
+    }
+
+    try {
+        return run(options);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
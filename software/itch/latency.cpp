@@ -0,0 +1,298 @@
+// End-to-end latency harness for the delivery paths.
+//
+//   g++ -std=c++17 -O2 -pthread latency.cpp generator.cpp -o latency
+//   ./latency [--transport ring|shm|udp|all] [--messages N] [--rate R] [--batch B]
+//             [--producer-cpu C] [--consumer-cpu C]
+//
+// A producer thread replays pre-generated order flow through each transport,
+// stamping every message as it is handed over; a reference consumer pinned to
+// another core stamps it on receipt and once decoded. The stamps are joined
+// by sequence number and reported per transport and per MessageType. The
+// rate (messages per second, 0 for flat out) keeps queueing from dominating
+// what is measured; --batch sets the messages per MoldUDP64 packet on UDP.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "message.hpp"      // ITCH protocol message structs
+#include "constant.hpp"     // ITCH constants
+#include "session.hpp"      // order flow
+#include "moldudp64.hpp"    // UDP framing
+#include "shm_ring.hpp"     // shared-memory transport
+#include "spsc_ring.hpp"    // in-process transport
+#include "rate_shaper.hpp"  // send pacing
+#include "latency.hpp"      // stamps and reporting
+
+namespace {
+
+volatile uint64_t g_sink = 0; // Keeps decoder results observable
+
+struct Options {
+    std::string transport = "all";
+    uint64_t messages = 1'000'000;
+    double rate = 1'000'000.0;
+    uint16_t batch = 1;
+    int producer_cpu = 0;
+    int consumer_cpu = 1;
+};
+
+struct Flow {
+    std::vector<uint8_t> data;
+    std::vector<uint16_t> lengths;
+
+    const uint8_t* message(size_t i) const { return data.data() + i * kMaxMessageSize; }
+};
+
+Flow generateFlow(uint64_t messages) {
+    Flow flow;
+    flow.data.resize(messages * kMaxMessageSize);
+    flow.lengths.resize(messages);
+    OrderFlowSession session{SessionConfig{}};
+    for (uint64_t i = 0; i < messages; ++i) {
+        flow.lengths[i] = static_cast<uint16_t>(session.next(flow.data.data() + i * kMaxMessageSize));
+    }
+    return flow;
+}
+
+void pinOrWarn(int cpu, const char* role) {
+    if (cpu >= 0 && !pinThread(cpu)) {
+        std::cerr << "could not pin " << role << " to cpu " << cpu << "\n";
+    }
+}
+
+// Replays the flow through send(sequence, message, length), stamping each
+// message immediately before it is handed to the transport.
+template <typename Send>
+void produce(const Flow &flow, const Options &options, const TscClock &clock, LatencyLog &log, Send &&send) {
+    pinOrWarn(options.producer_cpu, "producer");
+    RateShaperConfig config;
+    config.messages_per_second = options.rate;
+    RateShaper shaper(config, clock);
+    for (size_t i = 0; i < flow.lengths.size(); ++i) {
+        if (options.rate > 0) shaper.acquire();
+        uint64_t sequence = i + 1;
+        const uint8_t* message = flow.message(i);
+        log.type[sequence] = message[0];
+        log.sent[sequence] = readTsc();
+        send(sequence, message, flow.lengths[i]);
+    }
+}
+
+void consume(LatencyLog &log, uint64_t sequence, uint64_t received, const uint8_t* message, size_t length) {
+    g_sink = g_sink + decodeMessage(message, length);
+    if (sequence == 0 || sequence > log.capacity()) return;
+    log.received[sequence] = received;
+    log.decoded[sequence] = readTsc();
+}
+
+struct RingSlot {
+    uint64_t sequence;
+    uint16_t length;
+    uint8_t data[kMaxMessageSize];
+};
+
+LatencyLog runRing(const Flow &flow, const Options &options, const TscClock &clock) {
+    LatencyLog log(flow.lengths.size());
+    SpscRing<RingSlot> ring(1 << 16);
+    std::atomic<bool> done{false};
+
+    std::thread consumer([&] {
+        pinOrWarn(options.consumer_cpu, "consumer");
+        RingSlot slot;
+        for (;;) {
+            if (ring.tryPop(slot)) {
+                consume(log, slot.sequence, readTsc(), slot.data, slot.length);
+            } else if (done.load(std::memory_order_acquire) && ring.size() == 0) {
+                break;
+            }
+        }
+    });
+    produce(flow, options, clock, log, [&](uint64_t sequence, const uint8_t* message, uint16_t length) {
+        RingSlot slot;
+        slot.sequence = sequence;
+        slot.length = length;
+        std::memcpy(slot.data, message, length);
+        while (!ring.tryPush(slot)) {
+        }
+    });
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    return log;
+}
+
+LatencyLog runShm(const Flow &flow, const Options &options, const TscClock &clock) {
+    LatencyLog log(flow.lengths.size());
+    ShmRingPublisher publisher("", 1 << 16);
+    ShmRingReader reader = ShmRingReader::fromFd(publisher.fd());
+
+    std::thread consumer([&] {
+        pinOrWarn(options.consumer_cpu, "consumer");
+        uint8_t copy[kShmRingMaxMessage];
+        ShmMessageView view;
+        for (;;) {
+            ShmReadStatus status = reader.tryRead(view);
+            if (status == ShmReadStatus::Closed) break;
+            if (status != ShmReadStatus::Message) continue;
+            uint64_t received = readTsc();
+            std::memcpy(copy, view.data, view.length);
+            if (reader.stillValid(view)) {
+                consume(log, view.sequence, received, copy, view.length);
+            }
+        }
+    });
+    produce(flow, options, clock, log, [&](uint64_t, const uint8_t* message, uint16_t length) {
+        publisher.publish(message, length);
+    });
+    publisher.close();
+    consumer.join();
+    return log;
+}
+
+LatencyLog runUdp(const Flow &flow, const Options &options, const TscClock &clock) {
+    LatencyLog log(flow.lengths.size());
+    int rx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (rx < 0 || tx < 0) {
+        throw std::runtime_error("latency: socket() failed");
+    }
+    int buffer = 16 << 20;
+    ::setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (::bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::getsockname(rx, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0 ||
+        ::connect(tx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(rx);
+        ::close(tx);
+        throw std::runtime_error("latency: cannot set up loopback sockets");
+    }
+
+    std::atomic<bool> done{false};
+    std::thread consumer([&] {
+        pinOrWarn(options.consumer_cpu, "consumer");
+        uint8_t packet[kMoldHeaderSize + kMoldMaxPayload];
+        auto idle_since = std::chrono::steady_clock::now();
+        for (;;) {
+            ssize_t n = ::recv(rx, packet, sizeof(packet), MSG_DONTWAIT);
+            if (n <= 0) {
+                // The end of session packet can be dropped like any other.
+                if (!done.load(std::memory_order_acquire)) {
+                    idle_since = std::chrono::steady_clock::now();
+                } else if (std::chrono::steady_clock::now() - idle_since > std::chrono::milliseconds(200)) {
+                    break;
+                }
+                continue;
+            }
+            uint64_t received = readTsc();
+            size_t length = static_cast<size_t>(n);
+            if (length >= kMoldHeaderSize && readMoldHeader(packet).message_count == kMoldEndOfSession) break;
+            forEachMoldMessage(packet, length, [&](uint64_t sequence, const uint8_t* message, uint16_t message_length) {
+                consume(log, sequence, received, message, message_length);
+            });
+        }
+    });
+
+    MoldPacketBuilder builder(makeMoldSession("LATENCY"));
+    auto flush = [&] {
+        if (builder.empty()) return;
+        ::send(tx, builder.data(), builder.finish(), 0);
+        builder.reset();
+    };
+    produce(flow, options, clock, log, [&](uint64_t, const uint8_t* message, uint16_t length) {
+        if (!builder.append(message, length)) {
+            flush();
+            builder.append(message, length);
+        }
+        if (builder.count() >= options.batch) flush();
+    });
+    flush();
+    size_t control = builder.control(kMoldEndOfSession);
+    for (int i = 0; i < 3; ++i) ::send(tx, builder.data(), control, 0);
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    ::close(rx);
+    ::close(tx);
+    return log;
+}
+
+void printRow(const std::string &name, const LatencySummary &s) {
+    std::cout << "  " << std::left << std::setw(52) << name << std::right << std::setw(10) << s.count
+              << std::fixed << std::setprecision(0)
+              << std::setw(9) << s.p50 << std::setw(9) << s.p90 << std::setw(9) << s.p99
+              << std::setw(9) << s.p999 << std::setw(11) << s.max << std::setw(9) << s.mean << "\n";
+}
+
+void printReport(const std::string &transport, const LatencyReport &report) {
+    std::cout << "\n" << transport << ": " << report.sent << " sent, " << report.lost << " lost\n";
+    std::cout << "  " << std::left << std::setw(52) << "ns" << std::right << std::setw(10) << "count"
+              << std::setw(9) << "p50" << std::setw(9) << "p90" << std::setw(9) << "p99"
+              << std::setw(9) << "p99.9" << std::setw(11) << "max" << std::setw(9) << "mean" << "\n";
+    printRow("send -> receive", report.receive);
+    printRow("receive -> decoded", report.decode);
+    printRow("end to end", report.end_to_end);
+    for (size_t t = 0; t < kMessageTypeCount; ++t) {
+        if (report.per_type[t].count == 0) continue;
+        printRow("  " + toString(kMessageTypes[t]), report.per_type[t]);
+    }
+}
+
+bool isTransport(const std::string &name) {
+    return name == "ring" || name == "shm" || name == "udp" || name == "all";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (std::thread::hardware_concurrency() < 2) {
+        options.producer_cpu = options.consumer_cpu = -1;
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--transport" && i + 1 < argc && isTransport(argv[i + 1])) {
+            options.transport = argv[++i];
+        } else if (arg == "--messages" && i + 1 < argc) {
+            options.messages = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rate = std::stod(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.batch = static_cast<uint16_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--producer-cpu" && i + 1 < argc) {
+            options.producer_cpu = std::stoi(argv[++i]);
+        } else if (arg == "--consumer-cpu" && i + 1 < argc) {
+            options.consumer_cpu = std::stoi(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--transport ring|shm|udp|all] [--messages N] [--rate R]"
+                      << " [--batch B] [--producer-cpu C] [--consumer-cpu C]\n";
+            return 1;
+        }
+    }
+
+    TscClock clock = TscClock::calibrate(std::chrono::milliseconds(200));
+    Flow flow = generateFlow(options.messages);
+    bool all = options.transport == "all";
+    try {
+        if (all || options.transport == "ring") printReport("in-process ring", joinLatencies(runRing(flow, options, clock), clock));
+        if (all || options.transport == "shm") printReport("shared-memory ring", joinLatencies(runShm(flow, options, clock), clock));
+        if (all || options.transport == "udp") printReport("loopback UDP", joinLatencies(runUdp(flow, options, clock), clock));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "\nchecksum " << g_sink << "\n";
+    return 0;
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "message.hpp"   // ITCH protocol message structs
+#include "constant.hpp"  // ITCH constants
+#include "tsc.hpp"       // TSC reads and calibration
+
+// Bookkeeping for end-to-end latency runs: the producer stamps each message as
+// it enters the delivery path, a consumer on another core stamps it when it
+// comes out and again once decoded, and the stamps are joined afterwards by
+// sequence number. Stamps are raw TSC reads from different cores, which
+// assumes an invariant, synchronized TSC (constant_tsc and nonstop_tsc in
+// /proc/cpuinfo); nothing is shared between the two threads while running.
+
+struct LatencyLog {
+    explicit LatencyLog(size_t messages)
+        : sent(messages + 1, 0), received(messages + 1, 0), decoded(messages + 1, 0), type(messages + 1, 0) {}
+
+    // Indexed by sequence number, starting at 1. The producer writes sent
+    // and type, the consumer received and decoded; 0 means not seen.
+    std::vector<uint64_t> sent;
+    std::vector<uint64_t> received;
+    std::vector<uint64_t> decoded;
+    std::vector<uint8_t> type;
+
+    size_t capacity() const { return sent.size() - 1; }
+};
+
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double max = 0.0;
+};
+
+// Sorts samples in place.
+inline LatencySummary summarize(std::vector<double> &samples) {
+    LatencySummary summary;
+    if (samples.empty()) return summary;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * static_cast<double>(samples.size() - 1))]; };
+    double sum = 0.0;
+    for (double sample : samples) sum += sample;
+    summary.count = samples.size();
+    summary.mean = sum / static_cast<double>(samples.size());
+    summary.p50 = at(0.50);
+    summary.p90 = at(0.90);
+    summary.p99 = at(0.99);
+    summary.p999 = at(0.999);
+    summary.max = samples.back();
+    return summary;
+}
+
+struct LatencyReport {
+    uint64_t sent = 0;
+    uint64_t lost = 0;                   // Sent but never decoded
+    LatencySummary receive;              // Send to receive
+    LatencySummary decode;               // Receive to decoded
+    LatencySummary end_to_end;           // Send to decoded
+    std::array<LatencySummary, kMessageTypeCount> per_type{}; // End to end, by messageTypeIndex
+};
+
+inline LatencyReport joinLatencies(const LatencyLog &log, const TscClock &clock) {
+    LatencyReport report;
+    std::vector<double> receive, decode, end_to_end;
+    std::array<std::vector<double>, kMessageTypeCount> per_type;
+    for (size_t seq = 1; seq < log.sent.size(); ++seq) {
+        if (log.sent[seq] == 0) continue;
+        ++report.sent;
+        if (log.decoded[seq] == 0) {
+            ++report.lost;
+            continue;
+        }
+        // Clamp the odd negative difference from cross-core TSC skew to 0.
+        auto delta = [&](uint64_t from, uint64_t to) { return to > from ? clock.toNs(to - from) : 0.0; };
+        receive.push_back(delta(log.sent[seq], log.received[seq]));
+        decode.push_back(delta(log.received[seq], log.decoded[seq]));
+        double total = delta(log.sent[seq], log.decoded[seq]);
+        end_to_end.push_back(total);
+        int index = messageTypeIndex(log.type[seq]);
+        if (index >= 0) per_type[static_cast<size_t>(index)].push_back(total);
+    }
+    report.receive = summarize(receive);
+    report.decode = summarize(decode);
+    report.end_to_end = summarize(end_to_end);
+    for (size_t t = 0; t < kMessageTypeCount; ++t) report.per_type[t] = summarize(per_type[t]);
+    return report;
+}
+
+// Reference consumer work: copies the message into its struct and folds the
+// fields a book builder would use. Returns the fold so it cannot be elided.
+inline uint64_t decodeMessage(const uint8_t* data, size_t length) {
+    auto as = [&](auto &msg) {
+        if (length >= sizeof(msg)) std::memcpy(&msg, data, sizeof(msg));
+        return msg;
+    };
+    switch (static_cast<MessageType>(data[0])) {
+        case MessageType::AddOrder: {
+            AddOrderMessage msg{};
+            as(msg);
+            return msg.order_reference_number + msg.shares + msg.price + static_cast<uint8_t>(msg.side);
+        }
+        case MessageType::OrderExecuted: {
+            OrderExecutedMessage msg{};
+            as(msg);
+            return msg.order_reference_number + msg.executed_shares + msg.match_number;
+        }
+        case MessageType::OrderCancel: {
+            OrderCancelMessage msg{};
+            as(msg);
+            return msg.order_reference_number + msg.cancelled_shares;
+        }
+        case MessageType::OrderDelete: {
+            OrderDeleteMessage msg{};
+            as(msg);
+            return msg.order_reference_number;
+        }
+        case MessageType::OrderReplace: {
+            OrderReplaceMessage msg{};
+            as(msg);
+            return msg.original_order_ref + msg.new_order_ref + msg.shares + msg.price;
+        }
+        case MessageType::Trade: {
+            TradeMessage msg{};
+            as(msg);
+            return msg.shares + msg.price + msg.match_number;
+        }
+        case MessageType::CrossTrade: {
+            CrossTradeMessage msg{};
+            as(msg);
+            return msg.shares + msg.cross_price + msg.match_number;
+        }
+        case MessageType::NOII: {
+            NOIIMessage msg{};
+            as(msg);
+            return msg.paired_shares + msg.imbalance_shares + msg.far_price + msg.near_price;
+        }
+        default: {
+            uint64_t fold = 0;
+            for (size_t i = 0; i < length; ++i) fold = fold * 31 + data[i];
+            return fold;
+        }
+    }
+}
+
+// Pins the calling thread to one CPU; returns false if that is not allowed.
+inline bool pinThread(int cpu) {
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
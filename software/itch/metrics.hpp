@@ -0,0 +1,248 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "constant.hpp" // ITCH constants
+
+// Live run metrics in a shared-memory page, for an external monitor
+// (itch_monitor.cpp) to attach to while the generator runs.
+//
+// The generating thread counts into plain local fields, so the hot path has
+// no atomics and no locks. Every publish interval it copies them into the
+// page under a seqlock: the sequence is odd while the snapshot is being
+// written, and readers retry until they see the same even sequence before
+// and after their copy. The publisher never waits for readers.
+//
+// shm_open needs -lrt on glibc older than 2.34.
+
+constexpr uint64_t kMetricsMagic = 0x4352544D48435449ULL; // "ITCHMTRC"
+constexpr uint32_t kMetricsVersion = 1;
+constexpr size_t kMetricsPageSize = 4096;
+constexpr size_t kMetricsMaxStages = 8;
+constexpr size_t kMetricsStageNameLength = 24;
+
+struct MetricsStage {
+    char name[kMetricsStageNameLength];
+    uint64_t depth;       // Items queued in this stage
+    uint64_t capacity;    // 0 if unbounded
+};
+
+struct MetricsSnapshot {
+    uint64_t publish_count;
+    uint64_t wall_ns;                          // steady_clock time of this publish
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t simulated_ns;                     // Message clock, nanoseconds since midnight
+    uint64_t live_orders;
+    double achieved_rate;                      // Messages per second since the previous publish
+    uint32_t stage_count;
+    uint32_t pid;                              // Publishing process
+    uint64_t by_type[kMessageTypeCount];       // Indexed by messageTypeIndex
+    MetricsStage stages[kMetricsMaxStages];
+};
+
+struct MetricsPage {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t snapshot_size;
+    alignas(64) std::atomic<uint64_t> sequence;  // Odd while the snapshot is being written
+    alignas(64) MetricsSnapshot snapshot;
+};
+
+static_assert(sizeof(MetricsPage) <= kMetricsPageSize, "MetricsPage must fit one page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "metrics page needs address-free 64-bit atomics");
+
+class MetricsPublisher {
+public:
+    // Creates (replacing any stale one) the POSIX shm object "/name".
+    explicit MetricsPublisher(const std::string &name,
+                              std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+        : name_(name.empty() || name[0] != '/' ? "/" + name : name), interval_(interval) {
+        ::shm_unlink(name_.c_str());
+        int fd = ::shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("MetricsPublisher: shm_open failed for " + name_);
+        }
+        if (::ftruncate(fd, kMetricsPageSize) < 0) {
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw std::runtime_error("MetricsPublisher: ftruncate failed");
+        }
+        void* base = ::mmap(nullptr, kMetricsPageSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            ::shm_unlink(name_.c_str());
+            throw std::runtime_error("MetricsPublisher: mmap failed");
+        }
+        page_ = static_cast<MetricsPage*>(base);
+        page_->version = kMetricsVersion;
+        page_->snapshot_size = sizeof(MetricsSnapshot);
+        page_->sequence.store(0, std::memory_order_relaxed);
+        local_.pid = static_cast<uint32_t>(::getpid());
+        last_wall_ns_ = wallNs();
+        // Readers check the magic last, so publish it after everything else.
+        std::atomic_thread_fence(std::memory_order_release);
+        page_->magic = kMetricsMagic;
+    }
+
+    ~MetricsPublisher() {
+        if (page_ != nullptr) {
+            ::munmap(page_, kMetricsPageSize);
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    MetricsPublisher(const MetricsPublisher &) = delete;
+    MetricsPublisher &operator=(const MetricsPublisher &) = delete;
+
+    // Hot path: plain increments, owned by the publishing thread.
+    void countMessage(const uint8_t* message, size_t length) {
+        int index = messageTypeIndex(message[0]);
+        if (index >= 0) ++local_.by_type[index];
+        ++local_.messages;
+        local_.bytes += length;
+    }
+
+    void setSimulatedTime(uint64_t ns_since_midnight) { local_.simulated_ns = ns_since_midnight; }
+    void setLiveOrders(uint64_t count) { local_.live_orders = count; }
+
+    // Registers a pipeline stage (or finds one already registered under
+    // name) and returns its index for setStageDepth.
+    size_t addStage(const std::string &name, uint64_t capacity = 0) {
+        std::string key = name.substr(0, kMetricsStageNameLength - 1);
+        for (size_t i = 0; i < local_.stage_count; ++i) {
+            if (key == local_.stages[i].name) {
+                local_.stages[i].capacity = capacity;
+                return i;
+            }
+        }
+        if (local_.stage_count == kMetricsMaxStages) {
+            throw std::length_error("MetricsPublisher: too many stages");
+        }
+        MetricsStage &stage = local_.stages[local_.stage_count];
+        std::memset(stage.name, 0, sizeof(stage.name));
+        std::memcpy(stage.name, key.data(), key.size());
+        stage.capacity = capacity;
+        return local_.stage_count++;
+    }
+
+    void setStageDepth(size_t stage, uint64_t depth) { local_.stages[stage].depth = depth; }
+
+    // True once the publish interval has elapsed; the caller then refreshes
+    // its gauges and calls publish(). The clock is only read every
+    // kClockStride calls, so this is cheap enough to call per message.
+    bool due() {
+        if (++calls_ % kClockStride != 0) return false;
+        return wallNs() - last_wall_ns_ >= static_cast<uint64_t>(interval_.count()) * 1'000'000ULL;
+    }
+
+    void publish() { publishAt(wallNs()); }
+
+    const std::string &name() const { return name_; }
+
+private:
+    static constexpr uint64_t kClockStride = 1024;
+
+    static uint64_t wallNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void publishAt(uint64_t now) {
+        double elapsed = static_cast<double>(now - last_wall_ns_) * 1e-9;
+        local_.achieved_rate = elapsed > 0.0 ? static_cast<double>(local_.messages - last_messages_) / elapsed : 0.0;
+        local_.wall_ns = now;
+        ++local_.publish_count;
+        last_wall_ns_ = now;
+        last_messages_ = local_.messages;
+
+        uint64_t sequence = page_->sequence.load(std::memory_order_relaxed);
+        page_->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&page_->snapshot, &local_, sizeof(local_));
+        page_->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    std::string name_;
+    std::chrono::milliseconds interval_;
+    MetricsPage* page_ = nullptr;
+    MetricsSnapshot local_{};
+    uint64_t calls_ = 0;
+    uint64_t last_wall_ns_ = 0;
+    uint64_t last_messages_ = 0;
+};
+
+class MetricsReader {
+public:
+    explicit MetricsReader(const std::string &name) : path_(name.empty() || name[0] != '/' ? "/" + name : name) {
+        int fd = ::shm_open(path_.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error("MetricsReader: no metrics page " + path_);
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(MetricsPage)) {
+            ::close(fd);
+            throw std::runtime_error("MetricsReader: metrics page not initialized");
+        }
+        inode_ = st.st_ino;
+        void* base = ::mmap(nullptr, kMetricsPageSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("MetricsReader: mmap failed");
+        }
+        page_ = static_cast<const MetricsPage*>(base);
+        if (page_->magic != kMetricsMagic || page_->version != kMetricsVersion ||
+            page_->snapshot_size != sizeof(MetricsSnapshot)) {
+            ::munmap(const_cast<MetricsPage*>(page_), kMetricsPageSize);
+            throw std::runtime_error("MetricsReader: not a metrics page or incompatible version");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    ~MetricsReader() {
+        ::munmap(const_cast<MetricsPage*>(page_), kMetricsPageSize);
+    }
+
+    MetricsReader(const MetricsReader &) = delete;
+    MetricsReader &operator=(const MetricsReader &) = delete;
+
+    // Copies a consistent snapshot out; false if the publisher kept
+    // rewriting it for max_attempts tries.
+    bool read(MetricsSnapshot &out, int max_attempts = 1000) const {
+        for (int attempt = 0; attempt < max_attempts; ++attempt) {
+            uint64_t before = page_->sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            std::memcpy(&out, &page_->snapshot, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (page_->sequence.load(std::memory_order_relaxed) == before) return true;
+        }
+        return false;
+    }
+
+    // True once the publisher has unlinked the page (or a newer run has
+    // replaced it); the mapping stays readable but will not change again.
+    bool detached() const {
+        int fd = ::shm_open(path_.c_str(), O_RDONLY, 0);
+        if (fd < 0) return true;
+        struct stat st{};
+        bool replaced = ::fstat(fd, &st) < 0 || st.st_ino != inode_;
+        ::close(fd);
+        return replaced;
+    }
+
+private:
+    std::string path_;
+    ino_t inode_ = 0;
+    const MetricsPage* page_ = nullptr;
+};
@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <string>
+#include <algorithm>
+
+// MoldUDP64 framing. Unlike the ITCH payload structs, every MoldUDP64 field
+// is big-endian on the wire, so headers are written through the helpers below.
+
+inline void storeBE16(uint8_t* dest, uint16_t value) {
+    dest[0] = static_cast<uint8_t>(value >> 8);
+    dest[1] = static_cast<uint8_t>(value);
+}
+
+inline void storeBE32(uint8_t* dest, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        dest[i] = static_cast<uint8_t>(value >> (8 * (3 - i)));
+    }
+}
+
+inline void storeBE64(uint8_t* dest, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        dest[i] = static_cast<uint8_t>(value >> (8 * (7 - i)));
+    }
+}
+
+inline uint16_t loadBE16(const uint8_t* src) {
+    return static_cast<uint16_t>((src[0] << 8) | src[1]);
+}
+
+inline uint32_t loadBE32(const uint8_t* src) {
+    return (static_cast<uint32_t>(src[0]) << 24) | (static_cast<uint32_t>(src[1]) << 16) |
+           (static_cast<uint32_t>(src[2]) << 8) | src[3];
+}
+
+// 48-bit big-endian field, e.g. an ITCH timestamp.
+inline uint64_t loadBE48(const uint8_t* src) {
+    uint64_t value = 0;
+    for (int i = 0; i < 6; ++i) {
+        value = (value << 8) | src[i];
+    }
+    return value;
+}
+
+inline uint64_t loadBE64(const uint8_t* src) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | src[i];
+    }
+    return value;
+}
+
+constexpr size_t kMoldSessionLength = 10;
+constexpr size_t kMoldHeaderSize = 20;            // session(10) + sequence(8) + count(2)
+constexpr size_t kMoldRequestSize = 20;           // session(10) + sequence(8) + requested count(2)
+constexpr size_t kMoldMaxPayload = 1400;          // keeps a packet inside a 1500 byte Ethernet MTU
+constexpr uint16_t kMoldEndOfSession = 0xFFFF;    // message_count value marking end of session
+
+using MoldSession = std::array<char, kMoldSessionLength>;
+
+inline MoldSession makeMoldSession(const std::string &name) {
+    MoldSession session;
+    std::fill(session.begin(), session.end(), ' ');
+    std::copy_n(name.begin(), std::min(name.size(), session.size()), session.begin());
+    return session;
+}
+
+// Decoded view of a MoldUDP64 downstream header or re-request packet.
+struct MoldHeader {
+    MoldSession session;
+    uint64_t sequence_number;     // Sequence number of the first message in the packet
+    uint16_t message_count;       // Messages in the packet (requested count for a re-request)
+};
+
+inline void writeMoldHeader(uint8_t* dest, const MoldHeader &header) {
+    std::memcpy(dest, header.session.data(), kMoldSessionLength);
+    storeBE64(dest + kMoldSessionLength, header.sequence_number);
+    storeBE16(dest + kMoldSessionLength + 8, header.message_count);
+}
+
+inline MoldHeader readMoldHeader(const uint8_t* src) {
+    MoldHeader header;
+    std::memcpy(header.session.data(), src, kMoldSessionLength);
+    header.sequence_number = loadBE64(src + kMoldSessionLength);
+    header.message_count = loadBE16(src + kMoldSessionLength + 8);
+    return header;
+}
+
+// Accumulates ITCH messages into a single MoldUDP64 packet. Each message block
+// is a 2 byte big-endian length followed by the message itself.
+class MoldPacketBuilder {
+public:
+    MoldPacketBuilder(const MoldSession &session, uint64_t first_sequence = 1)
+        : session_(session), next_sequence_(first_sequence) {
+        reset();
+    }
+
+    // Returns false when the message does not fit; the caller should finish()
+    // and send the current packet, then append again.
+    bool append(const void* message, uint16_t length) {
+        if (size_ + 2 + length > kMoldHeaderSize + kMoldMaxPayload) {
+            return false;
+        }
+        storeBE16(buffer_.data() + size_, length);
+        std::memcpy(buffer_.data() + size_ + 2, message, length);
+        size_ += 2 + length;
+        ++count_;
+        return true;
+    }
+
+    // Writes the header and returns the packet length. The packet stays valid
+    // until the next reset().
+    size_t finish() {
+        writeMoldHeader(buffer_.data(), MoldHeader{session_, first_sequence_, count_});
+        return size_;
+    }
+
+    // Starts the next packet; sequence numbers continue from the previous one.
+    void reset() {
+        next_sequence_ += count_;
+        first_sequence_ = next_sequence_;
+        count_ = 0;
+        size_ = kMoldHeaderSize;
+    }
+
+    // Heartbeat (count 0) or end of session (count 0xFFFF) packet carrying the
+    // next expected sequence number. Call only once the current packet is sent.
+    size_t control(uint16_t message_count) {
+        reset();
+        writeMoldHeader(buffer_.data(), MoldHeader{session_, next_sequence_, message_count});
+        return kMoldHeaderSize;
+    }
+
+    const uint8_t* data() const { return buffer_.data(); }
+    size_t size() const { return size_; }
+    uint16_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    uint64_t firstSequence() const { return first_sequence_; }
+    uint64_t nextSequence() const { return next_sequence_ + count_; }
+    const MoldSession &session() const { return session_; }
+
+private:
+    MoldSession session_;
+    uint64_t next_sequence_;
+    uint64_t first_sequence_ = 0;
+    uint16_t count_ = 0;
+    size_t size_ = kMoldHeaderSize;
+    std::array<uint8_t, kMoldHeaderSize + kMoldMaxPayload> buffer_{};
+};
+
+// Walks the message blocks of a received MoldUDP64 packet.
+// Calls fn(sequence_number, message, length) for each message and returns the
+// number of messages visited, stopping early on a truncated block.
+template <typename Fn>
+size_t forEachMoldMessage(const uint8_t* packet, size_t length, Fn &&fn) {
+    if (length < kMoldHeaderSize) {
+        return 0;
+    }
+    MoldHeader header = readMoldHeader(packet);
+    if (header.message_count == kMoldEndOfSession) {
+        return 0;
+    }
+    size_t offset = kMoldHeaderSize;
+    size_t visited = 0;
+    for (uint16_t i = 0; i < header.message_count; ++i) {
+        if (offset + 2 > length) break;
+        uint16_t message_length = loadBE16(packet + offset);
+        if (offset + 2 + message_length > length) break;
+        fn(header.sequence_number + i, packet + offset + 2, message_length);
+        offset += 2 + message_length;
+        ++visited;
+    }
+    return visited;
+}
@@ -0,0 +1,437 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "moldudp64.hpp"   // framing and big-endian helpers
+#include "mapped_file.hpp" // reader mapping
+
+// Packet captures of the MoldUDP64 feed, for lab tooling that expects pcap.
+//
+// The writer wraps each MoldUDP64 packet in synthetic Ethernet, IPv4 and UDP
+// headers and stamps it with the message clock (nanoseconds since midnight,
+// offset by the session date), in classic nanosecond pcap or pcapng. Records
+// are assembled in one large buffer and written with a single write() per
+// buffer. The reader maps a capture (either format, either byte order),
+// walks the records in place and hands the UDP payloads to
+// forEachMoldMessage, so captures round-trip through the same decoder as the
+// live feed. Capture files are host byte order, as libpcap writes them.
+
+enum class CaptureFormat : uint8_t { Pcap, PcapNg };
+
+constexpr uint32_t kPcapMagicMicros = 0xA1B2C3D4;
+constexpr uint32_t kPcapMagicNanos = 0xA1B23C4D;
+constexpr uint32_t kPcapNgSectionHeader = 0x0A0D0D0A;
+constexpr uint32_t kPcapNgInterfaceDescription = 0x00000001;
+constexpr uint32_t kPcapNgEnhancedPacket = 0x00000006;
+constexpr uint32_t kPcapNgByteOrderMagic = 0x1A2B3C4D;
+constexpr uint32_t kLinkTypeEthernet = 1;
+constexpr size_t kEthernetHeaderSize = 14;
+constexpr size_t kIpv4HeaderSize = 20;
+constexpr size_t kUdpHeaderSize = 8;
+constexpr size_t kFrameOverhead = kEthernetHeaderSize + kIpv4HeaderSize + kUdpHeaderSize;
+
+struct PcapConfig {
+    CaptureFormat format = CaptureFormat::Pcap;
+    uint64_t midnight_epoch_s = 0;                  // Unix time of the session date's midnight
+    std::array<uint8_t, 6> src_mac{0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    std::string src_ip = "10.0.0.1";
+    std::string dst_ip = "233.54.12.111";           // Multicast groups get the matching 01:00:5e MAC
+    uint16_t src_port = 40000;
+    uint16_t dst_port = 26477;
+    size_t buffer_bytes = 8u << 20;                 // Records are flushed a buffer at a time
+};
+
+struct PcapWriterStats {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;     // File bytes, headers included
+    uint64_t writes = 0;    // write() calls
+};
+
+// Timestamp of the first ITCH message in a MoldUDP64 packet, 0 if it has none.
+inline uint64_t moldPacketTimestamp(const uint8_t* packet, size_t length) {
+    if (length < kMoldHeaderSize + 2 + 11) return 0;
+    return loadBE48(packet + kMoldHeaderSize + 2 + 5);
+}
+
+class PcapWriter {
+public:
+    PcapWriter(const std::string &path, const PcapConfig &config = PcapConfig{}) : config_(config) {
+        if (::inet_pton(AF_INET, config.src_ip.c_str(), &src_ip_) != 1 ||
+            ::inet_pton(AF_INET, config.dst_ip.c_str(), &dst_ip_) != 1) {
+            throw std::invalid_argument("PcapWriter: bad IPv4 address");
+        }
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("PcapWriter: cannot create " + path);
+        }
+        buffer_.reserve(std::max<size_t>(config.buffer_bytes, 1 << 16));
+        buildTemplate();
+        writeFileHeader();
+    }
+
+    ~PcapWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    PcapWriter(const PcapWriter &) = delete;
+    PcapWriter &operator=(const PcapWriter &) = delete;
+
+    // Appends one UDP datagram carrying payload (normally a finished
+    // MoldUDP64 packet) stamped at ns_since_midnight.
+    void writePacket(const uint8_t* payload, size_t length, uint64_t ns_since_midnight) {
+        if (length > 0xFFFF - kIpv4HeaderSize - kUdpHeaderSize) {
+            throw std::invalid_argument("PcapWriter: payload too large for one datagram");
+        }
+        size_t frame = kFrameOverhead + length;
+        size_t padded = (frame + 3) & ~size_t{3};
+        size_t record = config_.format == CaptureFormat::Pcap ? 16 + frame : 28 + padded + 4;
+        if (buffer_.size() + record > buffer_.capacity()) flush();
+
+        uint64_t ns = config_.midnight_epoch_s * 1'000'000'000ULL + ns_since_midnight;
+        size_t at = buffer_.size();
+        buffer_.resize(at + record);
+        uint8_t* out = buffer_.data() + at;
+        if (config_.format == CaptureFormat::Pcap) {
+            put32(out, static_cast<uint32_t>(ns / 1'000'000'000ULL));
+            put32(out + 4, static_cast<uint32_t>(ns % 1'000'000'000ULL));
+            put32(out + 8, static_cast<uint32_t>(frame));
+            put32(out + 12, static_cast<uint32_t>(frame));
+            out += 16;
+        } else {
+            put32(out, kPcapNgEnhancedPacket);
+            put32(out + 4, static_cast<uint32_t>(record));
+            put32(out + 8, 0);                                  // Interface 0
+            put32(out + 12, static_cast<uint32_t>(ns >> 32));
+            put32(out + 16, static_cast<uint32_t>(ns));
+            put32(out + 20, static_cast<uint32_t>(frame));
+            put32(out + 24, static_cast<uint32_t>(frame));
+            std::memset(out + 28 + frame, 0, padded - frame);
+            put32(out + 28 + padded, static_cast<uint32_t>(record));
+            out += 28;
+        }
+        writeHeaders(out, length);
+        std::memcpy(out + kFrameOverhead, payload, length);
+        ++stats_.packets;
+    }
+
+    // Convenience for a finished packet builder, stamped with its first
+    // message's timestamp.
+    void writeMoldPacket(const uint8_t* packet, size_t length) {
+        writePacket(packet, length, moldPacketTimestamp(packet, length));
+    }
+
+    void flush() {
+        size_t offset = 0;
+        while (offset < buffer_.size()) {
+            ssize_t n = ::write(fd_, buffer_.data() + offset, buffer_.size() - offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("PcapWriter: write failed");
+            }
+            offset += static_cast<size_t>(n);
+            ++stats_.writes;
+        }
+        stats_.bytes += buffer_.size();
+        buffer_.clear();
+    }
+
+    void close() {
+        if (fd_ < 0) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    const PcapWriterStats &stats() const { return stats_; }
+
+    // Bytes held in the write buffer, for live metrics.
+    size_t buffered() const { return buffer_.size(); }
+    size_t bufferCapacity() const { return buffer_.capacity(); }
+
+private:
+    static void put16(uint8_t* dest, uint16_t value) { std::memcpy(dest, &value, 2); }
+    static void put32(uint8_t* dest, uint32_t value) { std::memcpy(dest, &value, 4); }
+
+    void writeFileHeader() {
+        if (config_.format == CaptureFormat::Pcap) {
+            uint8_t header[24];
+            put32(header, kPcapMagicNanos);
+            put16(header + 4, 2);
+            put16(header + 6, 4);
+            put32(header + 8, 0);              // thiszone
+            put32(header + 12, 0);             // sigfigs
+            put32(header + 16, 262144);        // snaplen
+            put32(header + 20, kLinkTypeEthernet);
+            buffer_.insert(buffer_.end(), header, header + sizeof(header));
+        } else {
+            uint8_t section[28];
+            put32(section, kPcapNgSectionHeader);
+            put32(section + 4, sizeof(section));
+            put32(section + 8, kPcapNgByteOrderMagic);
+            put16(section + 12, 1);
+            put16(section + 14, 0);
+            std::memset(section + 16, 0xFF, 8);  // Section length unknown
+            put32(section + 24, sizeof(section));
+            buffer_.insert(buffer_.end(), section, section + sizeof(section));
+
+            // if_tsresol = 9: nanosecond timestamps.
+            uint8_t interface[32];
+            put32(interface, kPcapNgInterfaceDescription);
+            put32(interface + 4, sizeof(interface));
+            put16(interface + 8, static_cast<uint16_t>(kLinkTypeEthernet));
+            put16(interface + 10, 0);
+            put32(interface + 12, 262144);      // snaplen
+            put16(interface + 16, 9);
+            put16(interface + 18, 1);
+            interface[20] = 9;
+            std::memset(interface + 21, 0, 3);
+            put32(interface + 24, 0);            // opt_endofopt
+            put32(interface + 28, sizeof(interface));
+            buffer_.insert(buffer_.end(), interface, interface + sizeof(interface));
+        }
+    }
+
+    // Everything but the lengths, IP id and checksums is fixed per writer.
+    void buildTemplate() {
+        uint8_t* eth = template_.data();
+        const uint8_t* dst = reinterpret_cast<const uint8_t*>(&dst_ip_);
+        if ((dst[0] & 0xF0) == 0xE0) {
+            uint8_t mac[6] = {0x01, 0x00, 0x5E, static_cast<uint8_t>(dst[1] & 0x7F), dst[2], dst[3]};
+            std::memcpy(eth, mac, 6);
+        } else {
+            uint8_t mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+            std::memcpy(eth, mac, 6);
+        }
+        std::memcpy(eth + 6, config_.src_mac.data(), 6);
+        storeBE16(eth + 12, 0x0800);
+
+        uint8_t* ip = eth + kEthernetHeaderSize;
+        ip[0] = 0x45;                           // IPv4, 20 byte header
+        ip[1] = 0;
+        storeBE16(ip + 6, 0x4000);              // Don't fragment
+        ip[8] = 64;                             // TTL
+        ip[9] = 17;                             // UDP
+        std::memcpy(ip + 12, &src_ip_, 4);
+        std::memcpy(ip + 16, &dst_ip_, 4);
+
+        uint8_t* udp = ip + kIpv4HeaderSize;
+        storeBE16(udp, config_.src_port);
+        storeBE16(udp + 2, config_.dst_port);
+        storeBE16(udp + 6, 0);                  // No UDP checksum, allowed over IPv4
+    }
+
+    void writeHeaders(uint8_t* out, size_t payload_length) {
+        std::memcpy(out, template_.data(), kFrameOverhead);
+        uint8_t* ip = out + kEthernetHeaderSize;
+        storeBE16(ip + 2, static_cast<uint16_t>(kIpv4HeaderSize + kUdpHeaderSize + payload_length));
+        storeBE16(ip + 4, ip_id_++);
+        uint32_t sum = 0;
+        for (size_t i = 0; i < kIpv4HeaderSize; i += 2) sum += loadBE16(ip + i);
+        while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+        storeBE16(ip + 10, static_cast<uint16_t>(~sum));
+        storeBE16(ip + kIpv4HeaderSize + 4, static_cast<uint16_t>(kUdpHeaderSize + payload_length));
+    }
+
+    PcapConfig config_;
+    int fd_ = -1;
+    uint32_t src_ip_ = 0;   // Network byte order
+    uint32_t dst_ip_ = 0;
+    uint16_t ip_id_ = 0;
+    std::array<uint8_t, kFrameOverhead> template_{};
+    std::vector<uint8_t> buffer_;
+    PcapWriterStats stats_;
+};
+
+// UDP payload of an Ethernet/IPv4/UDP frame (802.1Q tags allowed); false for
+// anything else, including IP fragments.
+inline bool udpPayload(const uint8_t* frame, size_t length, const uint8_t*&payload, size_t &payload_length) {
+    size_t offset = 12;
+    if (length < offset + 2) return false;
+    uint16_t ether_type = loadBE16(frame + offset);
+    while ((ether_type == 0x8100 || ether_type == 0x88A8) && length >= offset + 6) {
+        offset += 4;
+        ether_type = loadBE16(frame + offset);
+    }
+    offset += 2;
+    if (ether_type != 0x0800 || length < offset + kIpv4HeaderSize) return false;
+    const uint8_t* ip = frame + offset;
+    size_t ihl = static_cast<size_t>(ip[0] & 0x0F) * 4;
+    if ((ip[0] >> 4) != 4 || ihl < kIpv4HeaderSize || ip[9] != 17 || (loadBE16(ip + 6) & 0x3FFF) != 0) return false;
+    size_t ip_end = std::min<size_t>(length, offset + loadBE16(ip + 2));
+    offset += ihl;
+    if (ip_end < offset + kUdpHeaderSize) return false;
+    size_t udp_length = loadBE16(frame + offset + 4);
+    if (udp_length < kUdpHeaderSize || offset + udp_length > ip_end) return false;
+    payload = frame + offset + kUdpHeaderSize;
+    payload_length = udp_length - kUdpHeaderSize;
+    return true;
+}
+
+class PcapReader {
+public:
+    explicit PcapReader(const std::string &path) : file_(path) {
+        const uint8_t* data = file_.data();
+        if (file_.size() < 24) {
+            throw std::runtime_error("PcapReader: " + path + " is too short");
+        }
+        uint32_t magic;
+        std::memcpy(&magic, data, 4);
+        if (magic == kPcapNgSectionHeader) {
+            format_ = CaptureFormat::PcapNg;
+        } else if (magic == kPcapMagicMicros || magic == kPcapMagicNanos ||
+                   magic == __builtin_bswap32(kPcapMagicMicros) || magic == __builtin_bswap32(kPcapMagicNanos)) {
+            format_ = CaptureFormat::Pcap;
+            swap_ = magic == __builtin_bswap32(kPcapMagicMicros) || magic == __builtin_bswap32(kPcapMagicNanos);
+            nanos_ = get32(data) == kPcapMagicNanos;
+            if (get32(data + 20) != kLinkTypeEthernet) {
+                throw std::runtime_error("PcapReader: " + path + " is not an Ethernet capture");
+            }
+        } else {
+            throw std::runtime_error("PcapReader: " + path + " is not a pcap or pcapng file");
+        }
+    }
+
+    CaptureFormat format() const { return format_; }
+    size_t size() const { return file_.size(); }
+
+    // Calls fn(unix_ns, frame, captured_length) for every Ethernet packet
+    // and returns the number visited. Stops at a truncated record.
+    template <typename Fn>
+    size_t forEachPacket(Fn &&fn) {
+        return format_ == CaptureFormat::Pcap ? walkPcap(fn) : walkPcapNg(fn);
+    }
+
+    // Calls fn(sequence, unix_ns, message, length) for every ITCH message in
+    // every MoldUDP64 packet; returns the number of messages visited.
+    template <typename Fn>
+    size_t forEachMessage(Fn &&fn) {
+        size_t messages = 0;
+        forEachPacket([&](uint64_t ns, const uint8_t* frame, size_t length) {
+            const uint8_t* payload;
+            size_t payload_length;
+            if (!udpPayload(frame, length, payload, payload_length)) return;
+            messages += forEachMoldMessage(payload, payload_length, [&](uint64_t sequence, const uint8_t* message, uint16_t message_length) {
+                fn(sequence, ns, message, message_length);
+            });
+        });
+        return messages;
+    }
+
+private:
+    uint16_t get16(const uint8_t* src) const {
+        uint16_t value;
+        std::memcpy(&value, src, 2);
+        return swap_ ? __builtin_bswap16(value) : value;
+    }
+
+    uint32_t get32(const uint8_t* src) const {
+        uint32_t value;
+        std::memcpy(&value, src, 4);
+        return swap_ ? __builtin_bswap32(value) : value;
+    }
+
+    template <typename Fn>
+    size_t walkPcap(Fn &fn) {
+        const uint8_t* data = file_.data();
+        size_t size = file_.size();
+        size_t offset = 24;
+        size_t packets = 0;
+        uint64_t fraction_scale = nanos_ ? 1 : 1000;
+        while (offset + 16 <= size) {
+            uint64_t seconds = get32(data + offset);
+            uint64_t fraction = get32(data + offset + 4);
+            size_t captured = get32(data + offset + 8);
+            if (offset + 16 + captured > size) break;
+            fn(seconds * 1'000'000'000ULL + fraction * fraction_scale, data + offset + 16, captured);
+            offset += 16 + captured;
+            ++packets;
+        }
+        return packets;
+    }
+
+    template <typename Fn>
+    size_t walkPcapNg(Fn &fn) {
+        const uint8_t* data = file_.data();
+        size_t size = file_.size();
+        size_t offset = 0;
+        size_t packets = 0;
+        while (offset + 12 <= size) {
+            uint32_t type;
+            std::memcpy(&type, data + offset, 4);
+            if (type == kPcapNgSectionHeader) {
+                // Each section declares its own byte order.
+                uint32_t order;
+                std::memcpy(&order, data + offset + 8, 4);
+                swap_ = order == __builtin_bswap32(kPcapNgByteOrderMagic);
+                interfaces_.clear();
+            }
+            type = get32(data + offset);
+            size_t block = get32(data + offset + 4);
+            if (block < 12 || (block & 3) != 0 || offset + block > size) break;
+            const uint8_t* body = data + offset + 8;
+            size_t body_length = block - 12;
+            if (type == kPcapNgInterfaceDescription && body_length >= 8) {
+                interfaces_.push_back(interfaceFrom(body, body_length));
+            } else if (type == kPcapNgEnhancedPacket && body_length >= 20) {
+                uint32_t id = get32(body);
+                size_t captured = get32(body + 12);
+                if (id < interfaces_.size() && interfaces_[id].ethernet && 20 + captured <= body_length) {
+                    uint64_t ticks = (static_cast<uint64_t>(get32(body + 4)) << 32) | get32(body + 8);
+                    fn(interfaces_[id].toNs(ticks), body + 20, captured);
+                    ++packets;
+                }
+            }
+            offset += block;
+        }
+        return packets;
+    }
+
+    struct Interface {
+        bool ethernet = false;
+        uint8_t resolution = 6;    // if_tsresol; default microseconds
+
+        uint64_t toNs(uint64_t ticks) const {
+            if (resolution & 0x80) {
+                return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * 1'000'000'000ULL) >> (resolution & 0x7F));
+            }
+            uint64_t ns = ticks;
+            for (int i = resolution; i < 9; ++i) ns *= 10;
+            for (int i = 9; i < resolution; ++i) ns /= 10;
+            return ns;
+        }
+    };
+
+    Interface interfaceFrom(const uint8_t* body, size_t length) const {
+        Interface interface;
+        interface.ethernet = get16(body) == kLinkTypeEthernet;
+        size_t offset = 8;
+        while (offset + 4 <= length) {
+            uint16_t code = get16(body + offset);
+            uint16_t option_length = get16(body + offset + 2);
+            if (code == 0 || offset + 4 + option_length > length) break;
+            if (code == 9 && option_length >= 1) interface.resolution = body[offset + 4];
+            offset += 4 + ((option_length + 3u) & ~3u);
+        }
+        return interface;
+    }
+
+    MappedFile file_;
+    CaptureFormat format_ = CaptureFormat::Pcap;
+    bool swap_ = false;
+    bool nanos_ = false;
+    std::vector<Interface> interfaces_;
+};
@@ -0,0 +1,152 @@
+// Writes the synthetic feed as a packet capture, or reads one back.
+//
+//   g++ -std=c++17 -O2 pcap_tool.cpp generator.cpp -o pcap_tool
+//   ./pcap_tool write <capture> [--messages N] [--pcapng] [--midnight-epoch S] [--metrics NAME]
+//   ./pcap_tool read <capture>
+//
+// write frames OrderFlowSession output into MoldUDP64 packets stamped with
+// the message clock; read decodes every ITCH message in a pcap or pcapng
+// capture, checks sequence continuity and reports throughput. With --metrics
+// the writer publishes live counters for itch_monitor to attach to, with the
+// fill of the open MoldUDP64 packet and of the capture write buffer (bytes)
+// as stage depths.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <array>
+#include <chrono>
+#include <memory>
+
+#include "message.hpp"    // ITCH protocol message structs
+#include "constant.hpp"   // ITCH constants
+#include "session.hpp"    // order flow
+#include "moldudp64.hpp"  // framing
+#include "pcap.hpp"       // capture writer and reader
+#include "metrics.hpp"    // live metrics page
+
+namespace {
+
+struct CaptureStages {
+    size_t packet = 0;
+    size_t buffer = 0;
+};
+
+void publishMetrics(MetricsPublisher &metrics, const CaptureStages &stages, const OrderFlowSession &session,
+                    const MoldPacketBuilder &packet, const PcapWriter &writer) {
+    metrics.setSimulatedTime(session.timestamp());
+    metrics.setLiveOrders(session.liveOrderCount());
+    metrics.setStageDepth(stages.packet, packet.size());
+    metrics.setStageDepth(stages.buffer, writer.buffered());
+    metrics.publish();
+}
+
+int writeCapture(const std::string &path, uint64_t messages, const PcapConfig &config,
+                 const std::string &metrics_name) {
+    OrderFlowSession session{SessionConfig{}};
+    PcapWriter writer(path, config);
+    MoldPacketBuilder packet(makeMoldSession("PCAP"));
+    std::unique_ptr<MetricsPublisher> metrics;
+    CaptureStages stages;
+    if (!metrics_name.empty()) {
+        metrics = std::make_unique<MetricsPublisher>(metrics_name);
+        stages.packet = metrics->addStage("mold packet", kMoldHeaderSize + kMoldMaxPayload);
+        stages.buffer = metrics->addStage("capture buffer", writer.bufferCapacity());
+    }
+    uint8_t message[kMaxMessageSize];
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < messages; ++i) {
+        size_t length = session.next(message);
+        if (length == 0) break;
+        if (metrics) {
+            metrics->countMessage(message, length);
+            if (metrics->due()) publishMetrics(*metrics, stages, session, packet, writer);
+        }
+        if (!packet.append(message, static_cast<uint16_t>(length))) {
+            writer.writeMoldPacket(packet.data(), packet.finish());
+            packet.reset();
+            packet.append(message, static_cast<uint16_t>(length));
+        }
+    }
+    if (!packet.empty()) {
+        writer.writeMoldPacket(packet.data(), packet.finish());
+    }
+    uint64_t end_ns = session.timestamp();
+    writer.writePacket(packet.data(), packet.control(kMoldEndOfSession), end_ns);
+    writer.close();
+    if (metrics) publishMetrics(*metrics, stages, session, packet, writer);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const PcapWriterStats &stats = writer.stats();
+    std::cout << stats.packets << " packets, " << stats.bytes << " bytes in " << stats.writes
+              << " writes, " << std::fixed << std::setprecision(2) << seconds << " s\n";
+    return 0;
+}
+
+int readCapture(const std::string &path) {
+    PcapReader reader(path);
+    std::array<uint64_t, kMessageTypeCount> counts{};
+    uint64_t expected = 0;
+    uint64_t gaps = 0;
+    uint64_t duplicates = 0;
+    auto start = std::chrono::steady_clock::now();
+    size_t messages = reader.forEachMessage([&](uint64_t sequence, uint64_t, const uint8_t* message, uint16_t) {
+        int index = messageTypeIndex(message[0]);
+        if (index >= 0) ++counts[static_cast<size_t>(index)];
+        if (expected != 0 && sequence > expected) ++gaps;
+        if (expected != 0 && sequence < expected) ++duplicates;
+        if (sequence >= expected) expected = sequence + 1;
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << (reader.format() == CaptureFormat::Pcap ? "pcap" : "pcapng") << ": " << messages << " messages, "
+              << gaps << " gaps, " << duplicates << " duplicates, " << std::fixed << std::setprecision(2)
+              << (seconds > 0 ? static_cast<double>(reader.size()) / seconds / 1e9 : 0.0) << " GB/s\n";
+    for (size_t t = 0; t < kMessageTypeCount; ++t) {
+        if (counts[t] == 0) continue;
+        std::cout << "  " << std::left << std::setw(52) << toString(kMessageTypes[t]) << std::right
+                  << std::setw(14) << counts[t] << "\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " write <capture> [--messages N] [--pcapng] [--midnight-epoch S]"
+                  << " [--metrics NAME]\n"
+                  << "       " << argv[0] << " read <capture>\n";
+        return 1;
+    }
+    std::string mode = argv[1];
+    std::string path = argv[2];
+    uint64_t messages = 10'000'000;
+    PcapConfig config;
+    std::string metrics_name;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--messages" && i + 1 < argc) {
+            messages = std::stoull(argv[++i]);
+        } else if (arg == "--pcapng") {
+            config.format = CaptureFormat::PcapNg;
+        } else if (arg == "--midnight-epoch" && i + 1 < argc) {
+            config.midnight_epoch_s = std::stoull(argv[++i]);
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metrics_name = argv[++i];
+        } else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+
+    try {
+        if (mode == "write") return writeCapture(path, messages, config, metrics_name);
+        if (mode == "read") return readCapture(path);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cerr << "unknown mode " << mode << "\n";
+    return 1;
+}
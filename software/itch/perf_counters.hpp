@@ -0,0 +1,178 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Grouped hardware counters around a measured section, via perf_event_open.
+// Every counter is optional: whatever the kernel, CPU or perf_event_paranoid
+// setting refuses is simply reported as unavailable, and if even the cycle
+// counter cannot be opened the group is disabled and callers fall back to
+// wall-clock timing.
+
+enum class PerfEvent : uint8_t {
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    BranchMisses,
+    StoreForwardStalls,   // Loads blocked by store forwarding (Intel raw event)
+    Count,
+};
+
+constexpr size_t kPerfEventCount = static_cast<size_t>(PerfEvent::Count);
+
+inline const char* toString(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Cycles: return "cycles";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::L1DMisses: return "L1D misses";
+        case PerfEvent::LLCMisses: return "LLC misses";
+        case PerfEvent::BranchMisses: return "branch misses";
+        case PerfEvent::StoreForwardStalls: return "store-fwd stalls";
+        default: return "unknown";
+    }
+}
+
+struct PerfSample {
+    std::array<uint64_t, kPerfEventCount> values{};
+    std::array<bool, kPerfEventCount> valid{};
+
+    uint64_t operator[](PerfEvent event) const { return values[static_cast<size_t>(event)]; }
+    bool has(PerfEvent event) const { return valid[static_cast<size_t>(event)]; }
+
+    PerfSample &operator+=(const PerfSample &other) {
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            values[i] += other.values[i];
+            valid[i] = valid[i] || other.valid[i];
+        }
+        return *this;
+    }
+};
+
+class PerfCounterGroup {
+public:
+    PerfCounterGroup() { fds_.fill(-1); }
+    ~PerfCounterGroup() { close(); }
+
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    // Opens the counters for the calling thread. Returns false (timing only)
+    // when the group leader cannot be opened.
+    bool open() {
+#if defined(__linux__)
+        close();
+        fds_[index(PerfEvent::Cycles)] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+        leader_ = fds_[index(PerfEvent::Cycles)];
+        if (leader_ < 0) {
+            return false;
+        }
+        fds_[index(PerfEvent::Instructions)] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, leader_);
+        fds_[index(PerfEvent::L1DMisses)] = openCounter(PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), leader_);
+        fds_[index(PerfEvent::LLCMisses)] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader_);
+        fds_[index(PerfEvent::BranchMisses)] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, leader_);
+        if (isIntel()) {
+            // LD_BLOCKS.STORE_FORWARD: event 0x03, umask 0x02.
+            fds_[index(PerfEvent::StoreForwardStalls)] = openCounter(PERF_TYPE_RAW, 0x0203, leader_);
+        }
+        // Group reads return values in the order members were opened.
+        order_count_ = 0;
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            if (fds_[i] >= 0) order_[order_count_++] = i;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool available() const { return leader_ >= 0; }
+
+    bool has(PerfEvent event) const { return fds_[index(event)] >= 0; }
+
+    void start() {
+#if defined(__linux__)
+        if (leader_ < 0) return;
+        ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Stops counting and returns the counts since start(), scaled up if the
+    // kernel had to multiplex the group.
+    PerfSample stop() {
+        PerfSample sample;
+#if defined(__linux__)
+        if (leader_ < 0) return sample;
+        ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        // nr, time_enabled, time_running, then one value per member.
+        uint64_t buffer[3 + kPerfEventCount] = {};
+        ssize_t n = ::read(leader_, buffer, sizeof(buffer));
+        if (n < static_cast<ssize_t>(3 * sizeof(uint64_t))) return sample;
+        uint64_t nr = buffer[0];
+        double scale = (buffer[2] > 0 && buffer[2] < buffer[1]) ? static_cast<double>(buffer[1]) / buffer[2] : 1.0;
+        for (size_t i = 0; i < nr && i < order_count_; ++i) {
+            sample.values[order_[i]] = static_cast<uint64_t>(static_cast<double>(buffer[3 + i]) * scale);
+            sample.valid[order_[i]] = true;
+        }
+#endif
+        return sample;
+    }
+
+    void close() {
+#if defined(__linux__)
+        for (int &fd : fds_) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#endif
+        leader_ = -1;
+        order_count_ = 0;
+    }
+
+private:
+    static size_t index(PerfEvent event) { return static_cast<size_t>(event); }
+
+#if defined(__linux__)
+    static int openCounter(uint32_t type, uint64_t config, int group_fd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group_fd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+        return static_cast<int>(fd);
+    }
+
+    static bool isIntel() {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.rfind("vendor_id", 0) == 0) {
+                return line.find("GenuineIntel") != std::string::npos;
+            }
+        }
+        return false;
+    }
+#endif
+
+    std::array<int, kPerfEventCount> fds_;
+    std::array<size_t, kPerfEventCount> order_{};
+    size_t order_count_ = 0;
+    int leader_ = -1;
+};
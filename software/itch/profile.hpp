@@ -0,0 +1,338 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+
+#include "constant.hpp"   // ITCH constants
+#include "rng.hpp"        // deterministic random source
+#include "checkpoint.hpp" // binary encoding
+
+// Statistical description of a trading day, extracted from a real capture by
+// the profiler (profiler.hpp) and sampled by OrderFlowSession in place of its
+// hand-tuned rates, weights, sizes and offsets. Distributions are kept as raw
+// histogram counts, so partial profiles (per worker, or per capture) merge by
+// addition.
+
+constexpr uint64_t kProfileMagic = 0x4C46525048435449ULL; // "ITCHPRFL"
+constexpr uint32_t kProfileVersion = 1;
+constexpr size_t kProfileGapBuckets = 48;        // [0] zero gap, [k] gaps in [2^(k-1), 2^k) ns
+constexpr size_t kProfileExactShares = 1000;     // Sizes up to this are counted exactly
+constexpr size_t kProfileSizeBuckets = kProfileExactShares + 1 + 32; // then by power of two
+constexpr int32_t kProfileMaxOffsetTicks = 50;   // Price offsets clamp to +-this many ticks
+constexpr size_t kProfileOffsetBuckets = 2 * kProfileMaxOffsetTicks + 1;
+constexpr size_t kProfileEventCount = 6;         // Add, Execute, Cancel, Delete, Replace, Trade
+
+inline size_t profileGapBucket(uint64_t gap_ns) {
+    size_t bucket = gap_ns == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(gap_ns));
+    return std::min(bucket, kProfileGapBuckets - 1);
+}
+
+inline size_t profileSizeBucket(uint32_t shares) {
+    if (shares <= kProfileExactShares) return shares;
+    size_t log2 = static_cast<size_t>(31 - __builtin_clz(shares));
+    return kProfileExactShares + 1 + log2;
+}
+
+inline size_t profileOffsetBucket(int64_t ticks) {
+    ticks = std::max<int64_t>(-kProfileMaxOffsetTicks, std::min<int64_t>(kProfileMaxOffsetTicks, ticks));
+    return static_cast<size_t>(ticks + kProfileMaxOffsetTicks);
+}
+
+struct SymbolProfile {
+    std::string stock;
+    uint64_t adds = 0;       // A, F
+    uint64_t executes = 0;   // E, C
+    uint64_t cancels = 0;    // X
+    uint64_t deletes = 0;    // D
+    uint64_t replaces = 0;   // U
+    uint64_t trades = 0;     // P
+
+    uint64_t activity() const { return adds + executes + cancels + deletes + replaces + trades; }
+    double executeRatio() const { return adds > 0 ? static_cast<double>(executes) / adds : 0.0; }
+    double cancelRatio() const { return adds > 0 ? static_cast<double>(cancels + deletes) / adds : 0.0; }
+};
+
+struct WorkloadProfile {
+    using TypeCounts = std::array<uint64_t, kMessageTypeCount>;
+
+    uint64_t bucket_ns = 60'000'000'000ULL;    // Width of a type-mix time bucket
+    uint32_t tick = 100;                       // Price units per tick offset
+    uint64_t messages = 0;
+    std::vector<TypeCounts> type_mix;          // [timestamp / bucket_ns][messageTypeIndex]
+    std::array<uint64_t, kProfileGapBuckets> interarrival{};
+    std::array<uint64_t, kProfileSizeBuckets> order_size{};
+    std::array<uint64_t, kProfileOffsetBuckets> price_offset{}; // Ticks from the quote midpoint; positive rests away from it
+    std::vector<SymbolProfile> symbols;        // [stock_locate - 1]
+
+    TypeCounts &bucket(size_t index) {
+        if (index >= type_mix.size()) type_mix.resize(index + 1, TypeCounts{});
+        return type_mix[index];
+    }
+
+    SymbolProfile &symbol(uint16_t stock_locate) {
+        if (stock_locate > symbols.size()) symbols.resize(stock_locate);
+        return symbols[stock_locate - 1];
+    }
+
+    void merge(const WorkloadProfile &other) {
+        if (other.bucket_ns != bucket_ns) {
+            throw std::invalid_argument("WorkloadProfile: cannot merge profiles with different bucket widths");
+        }
+        messages += other.messages;
+        for (size_t i = 0; i < other.type_mix.size(); ++i) {
+            TypeCounts &counts = bucket(i);
+            for (size_t t = 0; t < kMessageTypeCount; ++t) counts[t] += other.type_mix[i][t];
+        }
+        for (size_t i = 0; i < kProfileGapBuckets; ++i) interarrival[i] += other.interarrival[i];
+        for (size_t i = 0; i < kProfileSizeBuckets; ++i) order_size[i] += other.order_size[i];
+        for (size_t i = 0; i < kProfileOffsetBuckets; ++i) price_offset[i] += other.price_offset[i];
+        if (other.symbols.size() > symbols.size()) symbols.resize(other.symbols.size());
+        for (size_t i = 0; i < other.symbols.size(); ++i) {
+            const SymbolProfile &from = other.symbols[i];
+            SymbolProfile &to = symbols[i];
+            if (to.stock.empty()) to.stock = from.stock;
+            to.adds += from.adds;
+            to.executes += from.executes;
+            to.cancels += from.cancels;
+            to.deletes += from.deletes;
+            to.replaces += from.replaces;
+            to.trades += from.trades;
+        }
+    }
+
+    // Names of the n most active symbols, busiest first; a natural symbol
+    // list for a session sampling this profile.
+    std::vector<std::string> busiestSymbols(size_t n) const {
+        std::vector<const SymbolProfile*> ranked;
+        for (const SymbolProfile &symbol : symbols) {
+            if (!symbol.stock.empty() && symbol.activity() > 0) ranked.push_back(&symbol);
+        }
+        std::sort(ranked.begin(), ranked.end(), [](const SymbolProfile* a, const SymbolProfile* b) {
+            return a->activity() > b->activity();
+        });
+        std::vector<std::string> names;
+        for (size_t i = 0; i < ranked.size() && i < n; ++i) names.push_back(ranked[i]->stock);
+        return names;
+    }
+
+    void save(CheckpointWriter &out) const {
+        out.u64(bucket_ns);
+        out.u32(tick);
+        out.u64(messages);
+        out.u64(type_mix.size());
+        for (const TypeCounts &counts : type_mix) {
+            for (uint64_t count : counts) out.u64(count);
+        }
+        for (uint64_t count : interarrival) out.u64(count);
+        for (uint64_t count : order_size) out.u64(count);
+        for (uint64_t count : price_offset) out.u64(count);
+        out.u64(symbols.size());
+        for (const SymbolProfile &symbol : symbols) {
+            out.str(symbol.stock);
+            out.u64(symbol.adds);
+            out.u64(symbol.executes);
+            out.u64(symbol.cancels);
+            out.u64(symbol.deletes);
+            out.u64(symbol.replaces);
+            out.u64(symbol.trades);
+        }
+    }
+
+    static WorkloadProfile load(CheckpointReader &in) {
+        WorkloadProfile profile;
+        profile.bucket_ns = in.u64();
+        profile.tick = in.u32();
+        profile.messages = in.u64();
+        if (profile.bucket_ns == 0 || profile.tick == 0) {
+            throw std::runtime_error("profile: zero bucket width or tick");
+        }
+        profile.type_mix.resize(in.count(8 * kMessageTypeCount));
+        for (TypeCounts &counts : profile.type_mix) {
+            for (uint64_t &count : counts) count = in.u64();
+        }
+        for (uint64_t &count : profile.interarrival) count = in.u64();
+        for (uint64_t &count : profile.order_size) count = in.u64();
+        for (uint64_t &count : profile.price_offset) count = in.u64();
+        profile.symbols.resize(in.count(4 + 6 * 8));
+        for (SymbolProfile &symbol : profile.symbols) {
+            symbol.stock = in.str();
+            symbol.adds = in.u64();
+            symbol.executes = in.u64();
+            symbol.cancels = in.u64();
+            symbol.deletes = in.u64();
+            symbol.replaces = in.u64();
+            symbol.trades = in.u64();
+        }
+        return profile;
+    }
+
+    void saveFile(const std::string &path) const {
+        CheckpointWriter out(kProfileMagic, kProfileVersion);
+        save(out);
+        out.writeFile(path);
+    }
+
+    static WorkloadProfile loadFile(const std::string &path) {
+        CheckpointReader in(path, kProfileMagic, kProfileVersion);
+        WorkloadProfile profile = load(in);
+        if (!in.atEnd()) {
+            throw std::runtime_error("profile: trailing data in " + path);
+        }
+        return profile;
+    }
+};
+
+// Draws from a WorkloadProfile. Everything is precomputed into cumulative
+// tables at construction, so each draw is one random number and a binary
+// search. The inter-arrival shape is the whole day's, stretched per time
+// bucket so the rate follows the captured intraday curve.
+class ProfileSampler {
+public:
+    // symbols is the session's symbol list; adds are spread across it in
+    // proportion to each name's captured add count (names missing from the
+    // profile get the weight of the least active one present).
+    ProfileSampler(const WorkloadProfile &profile, const std::vector<std::string> &symbols)
+        : bucket_ns_(profile.bucket_ns) {
+        gap_cdf_ = cumulative(profile.interarrival.data(), profile.interarrival.size());
+        size_cdf_ = cumulative(profile.order_size.data(), profile.order_size.size());
+        offset_cdf_ = cumulative(profile.price_offset.data(), profile.price_offset.size());
+
+        double mean_gap = histogramMeanGap(profile.interarrival);
+        std::array<uint64_t, kProfileEventCount> day{};
+        for (const WorkloadProfile::TypeCounts &counts : profile.type_mix) {
+            std::array<uint64_t, kProfileEventCount> events = eventCounts(counts);
+            for (size_t e = 0; e < kProfileEventCount; ++e) day[e] += events[e];
+        }
+        std::array<uint64_t, kProfileEventCount> day_thresholds = thresholds(day);
+        for (const WorkloadProfile::TypeCounts &counts : profile.type_mix) {
+            std::array<uint64_t, kProfileEventCount> events = eventCounts(counts);
+            bool any = false;
+            for (uint64_t count : events) any = any || count > 0;
+            event_thresholds_.push_back(any ? thresholds(events) : day_thresholds);
+
+            uint64_t total = 0;
+            for (uint64_t count : counts) total += count;
+            double bucket_mean = static_cast<double>(bucket_ns_) / static_cast<double>(std::max<uint64_t>(total, 1));
+            gap_scale_.push_back(mean_gap > 0.0 ? bucket_mean / mean_gap : 1.0);
+        }
+        if (event_thresholds_.empty()) {
+            event_thresholds_.push_back(day_thresholds);
+            gap_scale_.push_back(1.0);
+        }
+
+        std::unordered_map<std::string, uint64_t> adds;
+        for (const SymbolProfile &symbol : profile.symbols) {
+            if (symbol.adds > 0) adds[symbol.stock] += symbol.adds;
+        }
+        uint64_t floor = UINT64_MAX;
+        std::vector<uint64_t> weights(symbols.size(), 0);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            auto found = adds.find(symbols[i]);
+            if (found != adds.end()) {
+                weights[i] = found->second;
+                floor = std::min(floor, found->second);
+            }
+        }
+        for (uint64_t &weight : weights) {
+            if (weight == 0) weight = floor == UINT64_MAX ? 1 : floor;
+        }
+        symbol_cdf_ = cumulative(weights.data(), weights.size());
+    }
+
+    // Gap to the next message at simulated time now.
+    uint64_t gap(Rng &rng, uint64_t now) {
+        size_t bucket = draw(rng, gap_cdf_);
+        if (bucket == 0) return 0;
+        uint64_t low = 1ULL << (bucket - 1);
+        double gap = static_cast<double>(low + rng.below(low)) * gap_scale_[bucketIndex(now)];
+        return static_cast<uint64_t>(gap);
+    }
+
+    uint32_t shares(Rng &rng) {
+        size_t bucket = draw(rng, size_cdf_);
+        if (bucket <= kProfileExactShares) return std::max<uint32_t>(1, static_cast<uint32_t>(bucket));
+        uint64_t low = 1ULL << (bucket - kProfileExactShares - 1);
+        uint64_t shares = std::max<uint64_t>(low + rng.below(low), kProfileExactShares + 1);
+        return static_cast<uint32_t>(std::min<uint64_t>(shares, UINT32_MAX));
+    }
+
+    int32_t offsetTicks(Rng &rng) {
+        return static_cast<int32_t>(draw(rng, offset_cdf_)) - kProfileMaxOffsetTicks;
+    }
+
+    // Zero-based index into the session's symbol list.
+    size_t symbol(Rng &rng) { return draw(rng, symbol_cdf_); }
+
+    // Cumulative thresholds over Add, Execute, Cancel, Delete, Replace, Trade
+    // for the time bucket containing now, in OrderFlowSession's event order.
+    const std::array<uint64_t, kProfileEventCount> &eventThresholds(uint64_t now) const {
+        return event_thresholds_[bucketIndex(now)];
+    }
+
+private:
+    static std::vector<uint64_t> cumulative(const uint64_t* counts, size_t n) {
+        std::vector<uint64_t> cdf(n);
+        uint64_t total = 0;
+        for (size_t i = 0; i < n; ++i) cdf[i] = (total += counts[i]);
+        return cdf;
+    }
+
+    // Index i with probability counts[i] / total; an empty histogram yields 0.
+    static size_t draw(Rng &rng, const std::vector<uint64_t> &cdf) {
+        if (cdf.empty() || cdf.back() == 0) return 0;
+        uint64_t target = rng.below(cdf.back());
+        return static_cast<size_t>(std::upper_bound(cdf.begin(), cdf.end(), target) - cdf.begin());
+    }
+
+    static double histogramMeanGap(const std::array<uint64_t, kProfileGapBuckets> &histogram) {
+        double sum = 0.0;
+        uint64_t n = 0;
+        for (size_t bucket = 1; bucket < histogram.size(); ++bucket) {
+            double low = static_cast<double>(1ULL << (bucket - 1));
+            sum += 1.5 * low * static_cast<double>(histogram[bucket]);
+            n += histogram[bucket];
+        }
+        n += histogram[0];
+        return n > 0 ? sum / static_cast<double>(n) : 0.0;
+    }
+
+    static std::array<uint64_t, kProfileEventCount> eventCounts(const WorkloadProfile::TypeCounts &counts) {
+        auto count = [&](MessageType type) { return counts[messageTypeIndex(static_cast<uint8_t>(type))]; };
+        return {count(MessageType::AddOrder) + count(MessageType::AddOrderWithMPID),
+                count(MessageType::OrderExecuted) + count(MessageType::OrderExecutedWithPrice),
+                count(MessageType::OrderCancel),
+                count(MessageType::OrderDelete),
+                count(MessageType::OrderReplace),
+                count(MessageType::Trade)};
+    }
+
+    static std::array<uint64_t, kProfileEventCount> thresholds(const std::array<uint64_t, kProfileEventCount> &counts) {
+        uint64_t total = 0;
+        for (uint64_t count : counts) total += count;
+        std::array<uint64_t, kProfileEventCount> result{};
+        uint64_t cumulative = 0;
+        for (size_t e = 0; e < kProfileEventCount; ++e) {
+            cumulative += counts[e];
+            double fraction = total > 0 ? static_cast<double>(cumulative) / static_cast<double>(total) : 1.0;
+            result[e] = e + 1 == kProfileEventCount ? UINT64_MAX : Rng::threshold(fraction);
+        }
+        return result;
+    }
+
+    size_t bucketIndex(uint64_t now) const {
+        return std::min<size_t>(static_cast<size_t>(now / bucket_ns_), event_thresholds_.size() - 1);
+    }
+
+    uint64_t bucket_ns_;
+    std::vector<uint64_t> gap_cdf_;
+    std::vector<uint64_t> size_cdf_;
+    std::vector<uint64_t> offset_cdf_;
+    std::vector<uint64_t> symbol_cdf_;
+    std::vector<std::array<uint64_t, kProfileEventCount>> event_thresholds_;
+    std::vector<double> gap_scale_;
+};
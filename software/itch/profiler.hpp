@@ -0,0 +1,246 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message.hpp"     // ITCH protocol message structs
+#include "constant.hpp"    // ITCH constants
+#include "moldudp64.hpp"   // big-endian helpers
+#include "mapped_file.hpp" // capture mapping
+#include "profile.hpp"     // profile being built
+
+// Profiling pass over a real ITCH 5.0 BinaryFILE, the format NASDAQ publishes
+// daily: every message is prefixed with its 2-byte big-endian length, and
+// unlike this generator's structs every field is big-endian.
+//
+// The capture is mapped read-only and cut into one contiguous range per core.
+// Each worker resynchronizes to a message boundary near its nominal start,
+// decodes its range into a partial WorkloadProfile and the partials are
+// merged. State that spans a cut (the previous timestamp, a symbol's recent
+// quotes) starts cold in each worker, which costs a handful of samples per
+// cut and nothing else.
+
+struct ProfilerOptions {
+    unsigned threads = 0;                     // 0: one per hardware thread
+    uint64_t bucket_ns = 60'000'000'000ULL;   // Type-mix bucket width
+    uint32_t tick = 100;                      // $0.01 in Price(4) units
+};
+
+struct ProfilerStats {
+    uint64_t bytes = 0;
+    uint64_t messages = 0;
+    uint64_t unknown = 0;    // Types outside ITCH 5.0 or with an unexpected length
+    unsigned threads = 0;
+    double seconds = 0.0;
+};
+
+// Length of an ITCH 5.0 message of the given type, 0 for an unknown type.
+inline size_t itchMessageLength(uint8_t type) {
+    switch (static_cast<MessageType>(type)) {
+        case MessageType::SystemEvent: return sizeof(SystemEventMessage);
+        case MessageType::StockDirectory: return sizeof(StockDirectoryMessage);
+        case MessageType::StockTradingAction: return sizeof(StockTradingActionMessage);
+        case MessageType::RegSHORestriction: return sizeof(RegSHORestrictionMessage);
+        case MessageType::MarketParticipantPosition: return sizeof(MarketParticipantPositionMessage);
+        case MessageType::MWCBDeclineLevel: return 35;
+        case MessageType::MWCBStatus: return sizeof(MWCBStatusMessage);
+        case MessageType::IPOQuotingPeriodUpdate: return sizeof(IPOQuotingPeriodUpdateMessage);
+        case MessageType::LULDAuctionCollar: return sizeof(LULDAuctionCollarMessage);
+        case MessageType::OperationHalt: return sizeof(OperationalHaltMessage);
+        case MessageType::AddOrder: return sizeof(AddOrderMessage);
+        case MessageType::AddOrderWithMPID: return sizeof(AddOrderWithMPIDMessage);
+        case MessageType::OrderExecuted: return sizeof(OrderExecutedMessage);
+        case MessageType::OrderExecutedWithPrice: return sizeof(OrderExecutedWithPriceMessage);
+        case MessageType::OrderCancel: return sizeof(OrderCancelMessage);
+        case MessageType::OrderDelete: return sizeof(OrderDeleteMessage);
+        case MessageType::OrderReplace: return sizeof(OrderReplaceMessage);
+        case MessageType::Trade: return sizeof(TradeMessage);
+        case MessageType::CrossTrade: return sizeof(CrossTradeMessage);
+        case MessageType::BrokenTrade: return sizeof(BrokenTradeMessage);
+        case MessageType::NOII: return sizeof(NOIIMessage);
+        case MessageType::RPII: return sizeof(RetailPriceImprovementIndicator);
+        case MessageType::DRWCRPD: return sizeof(DRWCRPDMessage);
+        default: return 0;
+    }
+}
+
+class CaptureProfiler {
+public:
+    explicit CaptureProfiler(const ProfilerOptions &options = ProfilerOptions{}) : options_(options) {}
+
+    WorkloadProfile run(const std::string &path, ProfilerStats* stats = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile capture(path);
+        const uint8_t* data = capture.data();
+        size_t size = capture.size();
+
+        unsigned threads = options_.threads > 0 ? options_.threads : std::thread::hardware_concurrency();
+        threads = std::max(1u, threads);
+        if (size / threads < kMinRangeBytes) {
+            threads = static_cast<unsigned>(std::max<size_t>(1, size / kMinRangeBytes));
+        }
+
+        std::vector<size_t> cuts(threads + 1, size);
+        cuts[0] = 0;
+        for (unsigned i = 1; i < threads; ++i) {
+            cuts[i] = resync(data, size, std::max(cuts[i - 1], size / threads * i));
+        }
+
+        std::vector<Worker> workers(threads);
+        std::vector<std::thread> pool;
+        for (unsigned i = 0; i < threads; ++i) {
+            pool.emplace_back([&, i] {
+                try {
+                    workers[i].run(data, size, cuts[i], cuts[i + 1], options_);
+                } catch (...) {
+                    workers[i].error = std::current_exception();
+                }
+            });
+        }
+        for (std::thread &thread : pool) thread.join();
+
+        WorkloadProfile profile;
+        profile.bucket_ns = options_.bucket_ns;
+        profile.tick = options_.tick;
+        ProfilerStats totals;
+        for (Worker &worker : workers) {
+            if (worker.error) std::rethrow_exception(worker.error);
+            profile.merge(worker.profile);
+            totals.unknown += worker.unknown;
+        }
+        totals.bytes = size;
+        totals.messages = profile.messages;
+        totals.threads = threads;
+        totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (stats != nullptr) *stats = totals;
+        return profile;
+    }
+
+private:
+    static constexpr size_t kMinRangeBytes = 1 << 20;
+    static constexpr int kResyncFrames = 64;   // Consecutive well-formed frames that confirm a boundary
+
+    struct Quote {
+        uint32_t bid = 0;   // Most recent buy add price
+        uint32_t ask = 0;   // Most recent sell add price
+    };
+
+    struct Worker {
+        WorkloadProfile profile;
+        std::vector<Quote> quotes = std::vector<Quote>(65536);
+        uint64_t unknown = 0;
+        std::exception_ptr error;
+
+        void run(const uint8_t* data, size_t size, size_t begin, size_t end, const ProfilerOptions &options) {
+            profile.bucket_ns = options.bucket_ns;
+            profile.tick = options.tick;
+            uint64_t previous = UINT64_MAX;
+            size_t offset = begin;
+            while (offset < end) {
+                size_t length = offset + 2 <= size ? loadBE16(data + offset) : 0;
+                if (length == 0 || offset + 2 + length > size) {
+                    throw std::runtime_error("profiler: truncated message at offset " + std::to_string(offset));
+                }
+                const uint8_t* msg = data + offset + 2;
+                offset += 2 + length;
+                if (length < 11 || itchMessageLength(msg[0]) != length) {
+                    ++unknown;
+                    continue;
+                }
+                uint64_t timestamp = loadBE48(msg + 5);
+                if (previous != UINT64_MAX && timestamp >= previous) {
+                    ++profile.interarrival[profileGapBucket(timestamp - previous)];
+                }
+                previous = timestamp;
+                ++profile.messages;
+                ++profile.bucket(static_cast<size_t>(timestamp / options.bucket_ns))[messageTypeIndex(msg[0])];
+                decode(msg, options.tick);
+            }
+            if (offset != end) {
+                throw std::runtime_error("profiler: lost message framing before offset " + std::to_string(end));
+            }
+        }
+
+        void decode(const uint8_t* msg, uint32_t tick) {
+            uint16_t locate = loadBE16(msg + 1);
+            if (locate == 0) return;
+            switch (static_cast<MessageType>(msg[0])) {
+                case MessageType::StockDirectory:
+                    profile.symbol(locate).stock = symbolName(msg + 11);
+                    break;
+                case MessageType::AddOrder:
+                case MessageType::AddOrderWithMPID:
+                    add(locate, static_cast<char>(msg[19]), loadBE32(msg + 20), loadBE32(msg + 32), tick);
+                    break;
+                case MessageType::OrderExecuted:
+                case MessageType::OrderExecutedWithPrice:
+                    ++profile.symbol(locate).executes;
+                    break;
+                case MessageType::OrderCancel:
+                    ++profile.symbol(locate).cancels;
+                    break;
+                case MessageType::OrderDelete:
+                    ++profile.symbol(locate).deletes;
+                    break;
+                case MessageType::OrderReplace:
+                    ++profile.symbol(locate).replaces;
+                    break;
+                case MessageType::Trade:
+                    ++profile.symbol(locate).trades;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // The offset is measured from the midpoint of the symbol's most recent
+        // buy and sell adds, a cheap stand-in for the quote that needs no
+        // order book. Sub-penny prices (below $1) are left out.
+        void add(uint16_t locate, char side, uint32_t shares, uint32_t price, uint32_t tick) {
+            ++profile.symbol(locate).adds;
+            ++profile.order_size[profileSizeBucket(shares)];
+            Quote &quote = quotes[locate];
+            bool buy = side == static_cast<char>(Side::Buy);
+            if (quote.bid > 0 && quote.ask > 0 && price >= 100 * tick) {
+                int64_t mid2 = static_cast<int64_t>(quote.bid) + quote.ask;
+                int64_t away2 = buy ? mid2 - 2 * static_cast<int64_t>(price) : 2 * static_cast<int64_t>(price) - mid2;
+                int64_t ticks = away2 >= 0 ? (away2 + tick) / (2 * tick) : -((-away2 + tick) / (2 * tick));
+                ++profile.price_offset[profileOffsetBucket(ticks)];
+            }
+            (buy ? quote.bid : quote.ask) = price;
+        }
+    };
+
+    static std::string symbolName(const uint8_t* stock) {
+        std::string name(reinterpret_cast<const char*>(stock), 8);
+        name.erase(name.find_last_not_of(' ') + 1);
+        return name;
+    }
+
+    // First offset at or after from where kResyncFrames well-formed frames
+    // (or the rest of the file) follow back to back. Message lengths are fixed
+    // per type, so a false match is vanishingly unlikely; if one happened the
+    // previous worker would not land on it and reports lost framing.
+    static size_t resync(const uint8_t* data, size_t size, size_t from) {
+        for (size_t candidate = from; candidate < size; ++candidate) {
+            size_t offset = candidate;
+            int frames = 0;
+            while (frames < kResyncFrames && offset + 3 <= size) {
+                size_t length = loadBE16(data + offset);
+                if (length == 0 || length != itchMessageLength(data[offset + 2]) || offset + 2 + length > size) break;
+                offset += 2 + length;
+                ++frames;
+            }
+            if (frames == kResyncFrames || (frames > 0 && offset == size)) return candidate;
+        }
+        return size;
+    }
+
+    ProfilerOptions options_;
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "tsc.hpp" // TSC reads and calibration
+
+struct RateShaperConfig {
+    double messages_per_second = 1'000'000.0;  // Sustained rate
+    uint32_t burst_messages = 1;               // Token bucket depth: messages allowed back to back after idling
+    // Optional per-second rate profile, e.g. {10e6, 10e6, 2e6} for an opening
+    // burst. Second i of the run uses profile[i]; after the last entry the
+    // final rate is held. Empty means messages_per_second throughout.
+    std::vector<double> profile;
+};
+
+struct RateShaperStats {
+    uint64_t messages = 0;
+    uint64_t releases = 0;
+    double elapsed_ns = 0.0;
+    double achieved_rate = 0.0;        // Messages per second over the run
+    double target_rate = 0.0;          // Mean scheduled rate over the run
+    double mean_release_error_ns = 0.0;    // Mean lateness of releases against the schedule
+    double stddev_release_error_ns = 0.0;
+    double max_late_ns = 0.0;          // Worst release after its scheduled time
+};
+
+// Releases messages (or batches) on a schedule derived from the TSC.
+// Scheduling is GCRA, i.e. a token bucket expressed as a theoretical release
+// time: each release advances the schedule by count * interval rather than
+// from "now", so timing error does not accumulate into rate error.
+class RateShaper {
+public:
+    RateShaper(const RateShaperConfig &config, const TscClock &clock)
+        : config_(config), clock_(clock) {}
+
+    // Spins until count messages may be sent, then charges them.
+    void acquire(uint32_t count = 1) {
+        uint64_t now = readTsc();
+        if (!started_) start(now);
+        uint64_t release_at = earliestRelease();
+        while (now < release_at) {
+            now = readTsc();
+        }
+        charge(count, now, release_at);
+    }
+
+    // Non-blocking variant: charges and returns true only if count messages
+    // may be sent right now.
+    bool tryAcquire(uint32_t count = 1) {
+        uint64_t now = readTsc();
+        if (!started_) start(now);
+        uint64_t release_at = earliestRelease();
+        if (now < release_at) {
+            return false;
+        }
+        charge(count, now, release_at);
+        return true;
+    }
+
+    RateShaperStats stats() const {
+        RateShaperStats stats;
+        stats.messages = messages_;
+        stats.releases = releases_;
+        if (!started_ || releases_ == 0) {
+            return stats;
+        }
+        stats.elapsed_ns = clock_.toNs(last_release_ - start_tsc_);
+        if (stats.elapsed_ns > 0.0) {
+            stats.achieved_rate = static_cast<double>(messages_) * 1e9 / stats.elapsed_ns;
+        }
+        double scheduled_ns = tat_ / clock_.ticksPerNs();
+        if (scheduled_ns > 0.0) {
+            stats.target_rate = static_cast<double>(messages_) * 1e9 / scheduled_ns;
+        }
+        double n = static_cast<double>(releases_);
+        stats.mean_release_error_ns = error_sum_ns_ / n;
+        stats.stddev_release_error_ns = std::sqrt(std::max(0.0, error_sq_sum_ns_ / n - stats.mean_release_error_ns * stats.mean_release_error_ns));
+        stats.max_late_ns = max_late_ns_;
+        return stats;
+    }
+
+private:
+    void start(uint64_t now) {
+        started_ = true;
+        start_tsc_ = now;
+        tat_ = 0.0;
+        last_release_ = now;
+        updateInterval(0);
+    }
+
+    // Earliest tick at which the next release is allowed: the theoretical
+    // release time less the burst allowance.
+    uint64_t earliestRelease() const {
+        double earliest = tat_ - burst_ticks_;
+        return earliest > 0.0 ? start_tsc_ + static_cast<uint64_t>(earliest) : start_tsc_;
+    }
+
+    void charge(uint32_t count, uint64_t now, uint64_t release_at) {
+        double error_ns = clock_.toNs(now - std::min(now, release_at));
+        error_sum_ns_ += error_ns;
+        error_sq_sum_ns_ += error_ns * error_ns;
+        max_late_ns_ = std::max(max_late_ns_, error_ns);
+
+        uint64_t second = static_cast<uint64_t>(clock_.toNs(now - start_tsc_) / 1e9);
+        if (second != current_second_) {
+            updateInterval(second);
+        }
+        // After an idle period the schedule restarts from now; otherwise it
+        // continues from the previous theoretical release time. The burst
+        // allowance is applied only in earliestRelease().
+        tat_ = std::max(tat_, static_cast<double>(now - start_tsc_)) + count * interval_ticks_;
+        messages_ += count;
+        ++releases_;
+        last_release_ = now;
+    }
+
+    void updateInterval(uint64_t second) {
+        current_second_ = second;
+        double rate = config_.messages_per_second;
+        if (!config_.profile.empty()) {
+            rate = config_.profile[std::min<uint64_t>(second, config_.profile.size() - 1)];
+        }
+        interval_ticks_ = rate > 0.0 ? clock_.ticksPerNs() * 1e9 / rate : 0.0;
+        burst_ticks_ = interval_ticks_ * (config_.burst_messages > 0 ? config_.burst_messages - 1 : 0);
+    }
+
+    RateShaperConfig config_;
+    TscClock clock_;
+    bool started_ = false;
+    uint64_t start_tsc_ = 0;
+    uint64_t last_release_ = 0;
+    uint64_t current_second_ = 0;
+    // Theoretical release time of the next message, in ticks since
+    // start_tsc_. Kept relative so the double keeps sub-tick precision
+    // however large the absolute TSC is.
+    double tat_ = 0.0;
+    double interval_ticks_ = 0.0;
+    double burst_ticks_ = 0.0;
+
+    uint64_t messages_ = 0;
+    uint64_t releases_ = 0;
+    double error_sum_ns_ = 0.0;
+    double error_sq_sum_ns_ = 0.0;
+    double max_late_ns_ = 0.0;
+};
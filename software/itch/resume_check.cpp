@@ -0,0 +1,206 @@
+// Checks that checkpoint and resume reproduce the uninterrupted stream.
+//
+//   g++ -std=c++17 -O2 resume_check.cpp generator.cpp -o resume_check
+//   ./resume_check [--interarrival-ns N] [--seed S] [--profile PATH] [--messages N]
+//                  [--scratch PATH] [--at N]...
+//
+// One uninterrupted run records a hash of every message. The session is then
+// checkpointed at points across the day (mid directory, pre-market, mid
+// opening NOII burst, mid opening cross, continuous trading, mid closing NOII
+// burst, mid closing cross, post-market, plus any --at message counts),
+// restored from the file and run on; every message after the checkpoint must
+// match the reference byte for byte. The default interarrival keeps a whole
+// day to a few million messages; --messages caps runs driven by a profile.
+// Exits non-zero on any mismatch.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+
+#include "constant.hpp"    // ITCH constants
+#include "session.hpp"     // order flow and checkpoints
+#include "checkpoint.hpp"  // fnv1a64
+#include "profile.hpp"     // workload profile
+
+namespace {
+
+struct Reference {
+    std::vector<uint64_t> hashes;      // Per message, over its bytes
+    std::vector<uint8_t> types;
+    std::vector<uint64_t> timestamps;  // Session clock after each message
+};
+
+struct CheckPoint {
+    std::string name;
+    uint64_t at = 0;                   // Messages generated before the checkpoint
+};
+
+struct CheckResult {
+    bool passed = false;
+    uint64_t compared = 0;
+    uint64_t first_mismatch = 0;
+    size_t live_orders = 0;
+    double save_ms = 0.0;
+    double load_ms = 0.0;
+};
+
+uint64_t hashMessage(const uint8_t* message, size_t length) {
+    return fnv1a64(message, length) ^ length;
+}
+
+Reference runReference(const SessionConfig &config, uint64_t limit) {
+    Reference reference;
+    OrderFlowSession session(config);
+    uint8_t message[kMaxMessageSize];
+    while (limit == 0 || reference.hashes.size() < limit) {
+        size_t length = session.next(message);
+        if (length == 0) break;
+        reference.hashes.push_back(hashMessage(message, length));
+        reference.types.push_back(message[0]);
+        reference.timestamps.push_back(session.timestamp());
+    }
+    return reference;
+}
+
+// First index i >= from where messages i - 1 and i are both of type, i.e. a
+// checkpoint after i messages lands inside a run of that type.
+uint64_t insideRun(const Reference &reference, MessageType type, uint64_t from) {
+    for (uint64_t i = std::max<uint64_t>(from, 1); i < reference.types.size(); ++i) {
+        if (reference.types[i - 1] == static_cast<uint8_t>(type) && reference.types[i] == static_cast<uint8_t>(type)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+uint64_t firstAtOrAfter(const Reference &reference, uint64_t ns) {
+    for (uint64_t i = 0; i < reference.timestamps.size(); ++i) {
+        if (reference.timestamps[i] >= ns) return i;
+    }
+    return 0;
+}
+
+std::vector<CheckPoint> choosePoints(const Reference &reference, const SessionConfig &config) {
+    const AuctionConfig &auction = config.auction;
+    uint64_t close_window = firstAtOrAfter(reference, auction.close_noii_start_ns);
+    std::vector<CheckPoint> points = {
+        {"mid stock directory", std::min<uint64_t>(2, reference.hashes.size())},
+        {"pre-market", firstAtOrAfter(reference, config.start_time_ns + kNsPerHour)},
+        {"mid opening NOII burst", insideRun(reference, MessageType::NOII, 1)},
+        {"mid opening cross", insideRun(reference, MessageType::CrossTrade, 1)},
+        {"continuous trading", firstAtOrAfter(reference, (config.market_open_ns + config.market_close_ns) / 2)},
+        {"mid closing NOII burst", close_window > 0 ? insideRun(reference, MessageType::NOII, close_window) : 0},
+        {"mid closing cross", close_window > 0 ? insideRun(reference, MessageType::CrossTrade, close_window) : 0},
+        {"post-market", firstAtOrAfter(reference, config.market_close_ns + kNsPerHour)},
+    };
+    return points;
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+CheckResult checkResume(const SessionConfig &config, const Reference &reference, uint64_t at, const std::string &path) {
+    CheckResult result;
+    uint8_t message[kMaxMessageSize];
+    {
+        OrderFlowSession session(config);
+        for (uint64_t i = 0; i < at; ++i) session.next(message);
+        auto start = std::chrono::steady_clock::now();
+        session.saveCheckpoint(path, at + 1);
+        result.save_ms = msSince(start);
+        result.live_orders = session.liveOrderCount();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t next_sequence = 0;
+    OrderFlowSession resumed = OrderFlowSession::fromCheckpoint(path, &next_sequence);
+    result.load_ms = msSince(start);
+    std::remove(path.c_str());
+
+    result.first_mismatch = at;
+    if (next_sequence != at + 1 || resumed.messagesGenerated() != at) return result;
+    for (uint64_t i = at; i < reference.hashes.size(); ++i) {
+        size_t length = resumed.next(message);
+        if (length == 0 || hashMessage(message, length) != reference.hashes[i]) {
+            result.first_mismatch = i;
+            return result;
+        }
+        ++result.compared;
+    }
+    // The resumed run must end where the reference did, unless it was capped.
+    bool capped = !reference.hashes.empty() && reference.types.back() != static_cast<uint8_t>(MessageType::SystemEvent);
+    if (!capped && resumed.next(message) != 0) {
+        result.first_mismatch = reference.hashes.size();
+        return result;
+    }
+    result.passed = true;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SessionConfig config;
+    config.mean_interarrival_ns = 20'000'000.0;
+    uint64_t limit = 0;
+    std::string scratch = "resume_check.ckpt";
+    std::vector<uint64_t> extra;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--interarrival-ns" && i + 1 < argc) {
+                config.mean_interarrival_ns = std::stod(argv[++i]);
+            } else if (arg == "--seed" && i + 1 < argc) {
+                config.seed = std::stoull(argv[++i]);
+            } else if (arg == "--profile" && i + 1 < argc) {
+                config.profile = std::make_shared<const WorkloadProfile>(WorkloadProfile::loadFile(argv[++i]));
+            } else if (arg == "--messages" && i + 1 < argc) {
+                limit = std::stoull(argv[++i]);
+            } else if (arg == "--scratch" && i + 1 < argc) {
+                scratch = argv[++i];
+            } else if (arg == "--at" && i + 1 < argc) {
+                extra.push_back(std::stoull(argv[++i]));
+            } else {
+                std::cerr << "usage: " << argv[0] << " [--interarrival-ns N] [--seed S] [--profile PATH]"
+                          << " [--messages N] [--scratch PATH] [--at N]...\n";
+                return 1;
+            }
+        }
+
+        Reference reference = runReference(config, limit);
+        std::vector<CheckPoint> points = choosePoints(reference, config);
+        for (uint64_t at : extra) points.push_back({"at " + std::to_string(at), at});
+        std::cout << "reference: " << reference.hashes.size() << " messages\n";
+        std::cout << "  " << std::left << std::setw(52) << "checkpoint" << std::right << std::setw(12) << "at"
+                  << std::setw(10) << "orders" << std::setw(10) << "save ms" << std::setw(10) << "load ms"
+                  << "  result\n";
+
+        int failures = 0;
+        for (const CheckPoint &point : points) {
+            std::cout << "  " << std::left << std::setw(52) << point.name << std::right;
+            if (point.at == 0 || point.at >= reference.hashes.size()) {
+                std::cout << std::setw(12) << "-" << "  not reached\n";
+                continue;
+            }
+            CheckResult result = checkResume(config, reference, point.at, scratch);
+            std::cout << std::setw(12) << point.at << std::setw(10) << result.live_orders << std::fixed
+                      << std::setprecision(2) << std::setw(10) << result.save_ms << std::setw(10) << result.load_ms;
+            if (result.passed) {
+                std::cout << "  ok, " << result.compared << " messages match\n";
+            } else {
+                std::cout << "  MISMATCH at message " << result.first_mismatch << "\n";
+                ++failures;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
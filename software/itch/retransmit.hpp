@@ -0,0 +1,286 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "moldudp64.hpp" // MoldUDP64 framing
+
+// Recently sent messages, indexed by MoldUDP64 sequence number.
+// One writer (the send path) stores every message it frames; any number of
+// readers (the retransmission server) copy messages back out. Each slot is a
+// small seqlock, so the writer never waits on a reader and a reader that races
+// an overwrite simply reports a miss.
+class ReplayRing {
+public:
+    static constexpr size_t kSlotSize = 64;
+    static constexpr size_t kMaxMessageSize = kSlotSize - sizeof(uint64_t) - sizeof(uint16_t);
+
+    // capacity is rounded up to a power of two
+    explicit ReplayRing(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        mask_ = rounded - 1;
+        slots_.reset(new Slot[rounded]);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Sequence numbers start at 1 and must be stored in increasing order.
+    // Messages longer than kMaxMessageSize are not retained (none in ITCH 5.0 are).
+    void store(uint64_t sequence, const void* message, uint16_t length) {
+        Slot &slot = slots_[sequence & mask_];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        if (length > kMaxMessageSize) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.length = length;
+        std::memcpy(slot.data, message, length);
+        slot.sequence.store(sequence, std::memory_order_release);
+        newest_.store(sequence, std::memory_order_release);
+    }
+
+    // Copies the message into out (at least kMaxMessageSize bytes).
+    // Returns its length, or 0 if the sequence is no longer (or not yet) held.
+    uint16_t load(uint64_t sequence, uint8_t* out) const {
+        const Slot &slot = slots_[sequence & mask_];
+        if (sequence == 0 || slot.sequence.load(std::memory_order_acquire) != sequence) {
+            return 0;
+        }
+        uint16_t length = slot.length;
+        if (length > kMaxMessageSize) {
+            return 0;
+        }
+        std::memcpy(out, slot.data, length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            return 0;
+        }
+        return length;
+    }
+
+    // Highest sequence number stored so far (0 before the first store).
+    uint64_t newest() const { return newest_.load(std::memory_order_acquire); }
+
+    // Lowest sequence number that may still be held.
+    uint64_t oldest() const {
+        uint64_t newest_sequence = newest();
+        return newest_sequence > mask_ ? newest_sequence - mask_ : 1;
+    }
+
+private:
+    struct alignas(kSlotSize) Slot {
+        std::atomic<uint64_t> sequence{0};
+        uint16_t length = 0;
+        uint8_t data[kMaxMessageSize];
+    };
+    static_assert(sizeof(Slot) == kSlotSize, "ReplayRing slot must fill one cache line");
+
+    size_t mask_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<uint64_t> newest_{0};
+};
+
+// Frames messages into MoldUDP64 packets and records each one in a ReplayRing
+// so that gaps can be re-requested later.
+class RecordingPacketBuilder : public MoldPacketBuilder {
+public:
+    RecordingPacketBuilder(const MoldSession &session, ReplayRing &ring, uint64_t first_sequence = 1)
+        : MoldPacketBuilder(session, first_sequence), ring_(ring) {}
+
+    bool append(const void* message, uint16_t length) {
+        uint64_t sequence = nextSequence();
+        if (!MoldPacketBuilder::append(message, length)) {
+            return false;
+        }
+        ring_.store(sequence, message, length);
+        return true;
+    }
+
+private:
+    ReplayRing &ring_;
+};
+
+struct RetransmitStats {
+    uint64_t requests;          // Re-request packets received
+    uint64_t hits;              // Messages served from the ring
+    uint64_t misses;            // Requested messages no longer (or not yet) held
+    uint64_t rejected;          // Malformed packets or wrong session
+    uint64_t packets_sent;      // Response packets sent
+    uint64_t send_failures;     // Response packets sendto() did not accept
+};
+
+// Answers MoldUDP64 re-request packets over loopback UDP from a ReplayRing.
+// Runs on its own thread and only reads the ring, so the primary send path is
+// never blocked by retransmission traffic.
+class RetransmitServer {
+public:
+    // Maximum messages answered per re-request, as on the production server.
+    static constexpr uint16_t kMaxMessagesPerRequest = 0xFFFE;
+
+    RetransmitServer(const ReplayRing &ring, const MoldSession &session, uint16_t port,
+                     const std::string &bind_address = "127.0.0.1")
+        : ring_(ring), session_(session) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) {
+            throw std::runtime_error("RetransmitServer: socket() failed");
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd_);
+            throw std::runtime_error("RetransmitServer: bad bind address " + bind_address);
+        }
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd_);
+            throw std::runtime_error("RetransmitServer: bind() failed on port " + std::to_string(port));
+        }
+    }
+
+    ~RetransmitServer() {
+        stop();
+        ::close(fd_);
+    }
+
+    RetransmitServer(const RetransmitServer &) = delete;
+    RetransmitServer &operator=(const RetransmitServer &) = delete;
+
+    // Port actually bound (useful when constructed with port 0).
+    uint16_t port() const {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        return ntohs(addr.sin_port);
+    }
+
+    void start() {
+        if (running_.exchange(true)) return;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) return;
+        if (thread_.joinable()) thread_.join();
+    }
+
+    RetransmitStats stats() const {
+        return RetransmitStats{
+            requests_.load(std::memory_order_relaxed),
+            hits_.load(std::memory_order_relaxed),
+            misses_.load(std::memory_order_relaxed),
+            rejected_.load(std::memory_order_relaxed),
+            packets_sent_.load(std::memory_order_relaxed),
+            send_failures_.load(std::memory_order_relaxed),
+        };
+    }
+
+    // Handles one re-request and sends the response packets to peer.
+    // Exposed so the request path can be driven without the server thread.
+    void handleRequest(const uint8_t* request, size_t length, const sockaddr_in &peer) {
+        if (length != kMoldRequestSize) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        MoldHeader header = readMoldHeader(request);
+        if (header.session != session_ || header.sequence_number == 0) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        requests_.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t sequence = header.sequence_number;
+        uint64_t remaining = std::min(header.message_count, kMaxMessagesPerRequest);
+        uint8_t message[ReplayRing::kMaxMessageSize];
+        // Responses are sent from the first requested sequence; a miss ends the
+        // response because a MoldUDP64 packet cannot skip sequence numbers.
+        MoldPacketBuilder packet(session_, sequence);
+        while (remaining > 0) {
+            uint16_t message_length = ring_.load(sequence, message);
+            if (message_length == 0) {
+                misses_.fetch_add(remaining, std::memory_order_relaxed);
+                break;
+            }
+            if (!packet.append(message, message_length)) {
+                send(packet, peer);
+                packet.reset();
+                continue;
+            }
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            ++sequence;
+            --remaining;
+        }
+        if (!packet.empty()) {
+            send(packet, peer);
+            packet.reset();
+        }
+        // Every request is answered. A zero-count packet at the first sequence
+        // not served tells the client the rest is gone rather than delayed.
+        if (remaining > 0 || header.message_count == 0) {
+            send(packet, peer);
+        }
+    }
+
+private:
+    void send(MoldPacketBuilder &packet, const sockaddr_in &peer) {
+        size_t length = packet.finish();
+        ssize_t sent = ::sendto(fd_, packet.data(), length, 0, reinterpret_cast<const sockaddr*>(&peer), sizeof(peer));
+        if (sent != static_cast<ssize_t>(length)) {
+            send_failures_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        packets_sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run() {
+        uint8_t request[kMoldHeaderSize + 64];
+        pollfd pfd{fd_, POLLIN, 0};
+        while (running_.load(std::memory_order_relaxed)) {
+            if (::poll(&pfd, 1, 50) <= 0) {
+                continue;
+            }
+            // Drain everything queued before polling again.
+            for (;;) {
+                sockaddr_in peer{};
+                socklen_t peer_len = sizeof(peer);
+                ssize_t n = ::recvfrom(fd_, request, sizeof(request), MSG_DONTWAIT,
+                                       reinterpret_cast<sockaddr*>(&peer), &peer_len);
+                if (n < 0) break;
+                handleRequest(request, static_cast<size_t>(n), peer);
+            }
+        }
+    }
+
+    const ReplayRing &ring_;
+    MoldSession session_;
+    int fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> packets_sent_{0};
+    std::atomic<uint64_t> send_failures_{0};
+};
+
+// Builds a MoldUDP64 re-request packet for count messages starting at sequence.
+inline std::array<uint8_t, kMoldRequestSize> makeMoldRequest(const MoldSession &session, uint64_t sequence, uint16_t count) {
+    std::array<uint8_t, kMoldRequestSize> request{};
+    writeMoldHeader(request.data(), MoldHeader{session, sequence, count});
+    return request;
+}
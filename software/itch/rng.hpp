@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <array>
+
+// Deterministic random source shared by the simulation components.
+// xoshiro256** seeded through splitmix64: fast, portable and with a state small
+// enough to copy around, unlike std::mt19937_64 whose distributions are not
+// reproducible across standard libraries.
+
+inline uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        for (auto &word : state_) {
+            word = splitmix64(seed);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound) without modulo bias worth caring about here.
+    uint64_t below(uint64_t bound) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+
+    // Uniform in [0, 1).
+    double uniform() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+    // Threshold such that next() < threshold with the given probability.
+    static uint64_t threshold(double probability) {
+        if (probability <= 0.0) return 0;
+        if (probability >= 1.0) return UINT64_MAX;
+        return static_cast<uint64_t>(probability * 18446744073709551616.0);
+    }
+
+    const std::array<uint64_t, 4> &state() const { return state_; }
+    void setState(const std::array<uint64_t, 4> &state) { state_ = state; }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::array<uint64_t, 4> state_;
+};
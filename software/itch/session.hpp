@@ -0,0 +1,620 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "message.hpp"   // ITCH protocol message structs
+#include "constant.hpp"  // ITCH constants
+#include "generator.hpp" // packing helpers
+#include "rng.hpp"       // deterministic random source
+#include "auction.hpp"   // opening/closing cross
+#include "checkpoint.hpp" // state save/restore
+#include "profile.hpp"    // captured workload profile
+
+constexpr uint64_t kNsPerSecond = 1'000'000'000ULL;
+constexpr uint64_t kNsPerHour = 3600 * kNsPerSecond;
+constexpr size_t kMaxMessageSize = sizeof(NOIIMessage); // Largest ITCH 5.0 message
+
+struct SessionConfig {
+    std::vector<std::string> symbols{"AAPL", "MSFT", "NVDA", "AMZN", "GOOGL", "META", "TSLA", "AMD"};
+    uint64_t seed = 1;
+    uint64_t start_time_ns = 4 * kNsPerHour;                      // 04:00, start of messages
+    uint64_t market_open_ns = 9 * kNsPerHour + 30 * 60 * kNsPerSecond;
+    uint64_t market_close_ns = 16 * kNsPerHour;
+    uint64_t system_close_ns = 20 * kNsPerHour;
+    double mean_interarrival_ns = 1000.0;                         // Exponential gaps between messages
+    size_t max_live_orders = 1'000'000;                           // Caps resident order state
+    uint32_t initial_price = 1'000'000;                           // $100.0000
+    uint32_t tick = 100;                                          // $0.01
+    uint32_t max_price_offset_ticks = 20;                         // Resting orders sit within this many ticks of last
+    uint32_t round_lot = 100;
+
+    // Relative frequency of each order-flow event once orders are resting.
+    double add_weight = 0.42;
+    double execute_weight = 0.06;
+    double cancel_weight = 0.08;
+    double delete_weight = 0.38;
+    double replace_weight = 0.04;
+    double trade_weight = 0.02;
+
+    AuctionConfig auction;                                        // NOII and Cross Trade around the open and close
+
+    // When set, inter-arrival gaps, event mix per time bucket, add sizes,
+    // price offsets and symbol activity are sampled from this captured
+    // profile instead of the fixed parameters above.
+    std::shared_ptr<const WorkloadProfile> profile;
+};
+
+struct LiveOrder {
+    uint64_t order_ref;
+    uint32_t shares;
+    uint32_t price;
+    uint16_t stock_locate;
+    char side;
+};
+
+struct SymbolState {
+    std::array<char, 8> stock;
+    uint32_t last_price;
+};
+
+// Synthetic order flow for one trading day. Messages are encoded straight into
+// a caller-provided buffer so a run of any length allocates nothing per
+// message; resident state is the live order set, bounded by max_live_orders.
+class OrderFlowSession {
+public:
+    explicit OrderFlowSession(const SessionConfig &config)
+        : config_(config), rng_(config.seed), auction_(config.auction, config.seed) {
+        if (config.symbols.empty() || config.symbols.size() > 0xFFFF) {
+            throw std::invalid_argument("OrderFlowSession: need between 1 and 65535 symbols");
+        }
+        clock_.ns_since_midnight = config.start_time_ns;
+        symbols_.reserve(config.symbols.size());
+        for (const std::string &symbol : config.symbols) {
+            SymbolState state{};
+            packString(state.stock, symbol);
+            state.last_price = config.initial_price;
+            symbols_.push_back(state);
+        }
+        setWeights(config);
+        if (config.profile) {
+            sampler_ = std::make_shared<ProfileSampler>(*config.profile, config.symbols);
+        }
+        next_noii_ns_ = auction_.nextDissemination(clock_.ns_since_midnight, config.market_open_ns, config.market_close_ns);
+    }
+
+    // Writes the next message into out (at least kMaxMessageSize bytes) and
+    // returns its length, or 0 once End of Messages has been sent.
+    size_t next(uint8_t* out) {
+        size_t length = 0;
+        switch (phase_) {
+            case Phase::StartOfMessages:
+                length = systemEvent(out, static_cast<char>(SystemEventCode::StartOfMessages));
+                phase_ = Phase::Directory;
+                break;
+            case Phase::Directory:
+                length = stockDirectory(out, static_cast<uint16_t>(directory_index_ + 1));
+                if (++directory_index_ == symbols_.size()) phase_ = Phase::StartOfSystem;
+                break;
+            case Phase::StartOfSystem:
+                length = systemEvent(out, static_cast<char>(SystemEventCode::StartOfSystem));
+                phase_ = Phase::PreMarket;
+                break;
+            case Phase::PreMarket:
+            case Phase::Market:
+            case Phase::PostMarket:
+                length = orderFlowOrEvent(out);
+                break;
+            case Phase::EndOfSystem:
+                length = systemEvent(out, static_cast<char>(SystemEventCode::EndOfMessages));
+                phase_ = Phase::Done;
+                break;
+            case Phase::Done:
+                return 0;
+        }
+        ++messages_;
+        return length;
+    }
+
+    bool done() const { return phase_ == Phase::Done; }
+    uint64_t timestamp() const { return clock_.ns_since_midnight; }
+    uint64_t messagesGenerated() const { return messages_; }
+    uint64_t matchNumber() const { return match_number_; }
+    size_t liveOrderCount() const { return orders_.size(); }
+    const std::vector<LiveOrder> &liveOrders() const { return orders_; }
+    const std::vector<SymbolState> &symbols() const { return symbols_; }
+    const SessionConfig &config() const { return config_; }
+
+    // Snapshots the complete generator state, configuration included, so a
+    // restored session continues the stream byte for byte. next_sequence
+    // carries the caller's output sequence number (e.g. MoldUDP64) along;
+    // checkpoint on a packet boundary so no partially built packet is lost.
+    void saveCheckpoint(const std::string &path, uint64_t next_sequence = 0) const {
+        CheckpointWriter out;
+        out.reserve(orders_.size() * 19 + symbols_.size() * 64 + 4096);
+        saveConfig(out);
+        out.u64(next_sequence);
+
+        for (uint64_t word : rng_.state()) out.u64(word);
+        out.u64(clock_.ns_since_midnight);
+        out.u8(static_cast<uint8_t>(phase_));
+        out.u64(directory_index_);
+        out.u16(tracking_number_);
+        out.u64(next_order_ref_);
+        out.u64(match_number_);
+        out.u64(messages_);
+        out.u64(next_noii_ns_);
+        out.u8(static_cast<uint8_t>(burst_));
+        out.u64(burst_cursor_);
+        for (const SymbolState &symbol : symbols_) out.u32(symbol.last_price);
+        out.u64(orders_.size());
+        for (const LiveOrder &order : orders_) {
+            out.u64(order.order_ref);
+            out.u32(order.shares);
+            out.u32(order.price);
+            out.u16(order.stock_locate);
+            out.u8(static_cast<uint8_t>(order.side));
+        }
+        auction_.save(out);
+        out.writeFile(path);
+    }
+
+    static OrderFlowSession fromCheckpoint(const std::string &path, uint64_t* next_sequence = nullptr) {
+        CheckpointReader in(path);
+        OrderFlowSession session(loadConfig(in));
+        uint64_t sequence = in.u64();
+        if (next_sequence != nullptr) *next_sequence = sequence;
+
+        std::array<uint64_t, 4> state;
+        for (uint64_t &word : state) word = in.u64();
+        session.rng_.setState(state);
+        session.clock_.ns_since_midnight = in.u64();
+        session.phase_ = static_cast<Phase>(in.u8());
+        session.directory_index_ = in.u64();
+        session.tracking_number_ = in.u16();
+        session.next_order_ref_ = in.u64();
+        session.match_number_ = in.u64();
+        session.messages_ = in.u64();
+        session.next_noii_ns_ = in.u64();
+        session.burst_ = static_cast<Burst>(in.u8());
+        session.burst_cursor_ = in.u64();
+        for (SymbolState &symbol : session.symbols_) symbol.last_price = in.u32();
+        session.orders_.resize(in.count(19));
+        for (LiveOrder &order : session.orders_) {
+            order.order_ref = in.u64();
+            order.shares = in.u32();
+            order.price = in.u32();
+            order.stock_locate = in.u16();
+            order.side = static_cast<char>(in.u8());
+        }
+        session.auction_.load(in);
+        if (!in.atEnd()) {
+            throw std::runtime_error("checkpoint: trailing data in " + path);
+        }
+        // The book view is a pure function of the live orders, which do not
+        // change during a burst, so rebuilding it reproduces the original.
+        if (session.burst_ != Burst::None) {
+            session.auction_.snapshotBook(session.orders_, session.symbols_.size());
+        }
+        return session;
+    }
+
+private:
+    enum class Phase : uint8_t { StartOfMessages, Directory, StartOfSystem, PreMarket, Market, PostMarket, EndOfSystem, Done };
+    enum class Event : uint8_t { Add, Execute, Cancel, Delete, Replace, Trade };
+    enum class Burst : uint8_t { None, Imbalance, Cross };
+
+    void saveConfig(CheckpointWriter &out) const {
+        out.u64(config_.symbols.size());
+        for (const std::string &symbol : config_.symbols) out.str(symbol);
+        out.u64(config_.seed);
+        out.u64(config_.start_time_ns);
+        out.u64(config_.market_open_ns);
+        out.u64(config_.market_close_ns);
+        out.u64(config_.system_close_ns);
+        out.f64(config_.mean_interarrival_ns);
+        out.u64(config_.max_live_orders);
+        out.u32(config_.initial_price);
+        out.u32(config_.tick);
+        out.u32(config_.max_price_offset_ticks);
+        out.u32(config_.round_lot);
+        out.f64(config_.add_weight);
+        out.f64(config_.execute_weight);
+        out.f64(config_.cancel_weight);
+        out.f64(config_.delete_weight);
+        out.f64(config_.replace_weight);
+        out.f64(config_.trade_weight);
+        saveAuctionConfig(out, config_.auction);
+        out.u8(config_.profile ? 1 : 0);
+        if (config_.profile) config_.profile->save(out);
+    }
+
+    static SessionConfig loadConfig(CheckpointReader &in) {
+        SessionConfig config;
+        config.symbols.resize(in.count(4));
+        for (std::string &symbol : config.symbols) symbol = in.str();
+        config.seed = in.u64();
+        config.start_time_ns = in.u64();
+        config.market_open_ns = in.u64();
+        config.market_close_ns = in.u64();
+        config.system_close_ns = in.u64();
+        config.mean_interarrival_ns = in.f64();
+        config.max_live_orders = in.u64();
+        config.initial_price = in.u32();
+        config.tick = in.u32();
+        config.max_price_offset_ticks = in.u32();
+        config.round_lot = in.u32();
+        config.add_weight = in.f64();
+        config.execute_weight = in.f64();
+        config.cancel_weight = in.f64();
+        config.delete_weight = in.f64();
+        config.replace_weight = in.f64();
+        config.trade_weight = in.f64();
+        config.auction = loadAuctionConfig(in);
+        if (in.u8() != 0) {
+            config.profile = std::make_shared<const WorkloadProfile>(WorkloadProfile::load(in));
+        }
+        return config;
+    }
+
+    void setWeights(const SessionConfig &config) {
+        const double weights[] = {config.add_weight, config.execute_weight, config.cancel_weight,
+                                  config.delete_weight, config.replace_weight, config.trade_weight};
+        double total = 0.0;
+        for (double weight : weights) total += weight;
+        double cumulative = 0.0;
+        for (size_t i = 0; i < event_thresholds_.size(); ++i) {
+            cumulative += total > 0.0 ? weights[i] / total : 0.0;
+            event_thresholds_[i] = i + 1 == event_thresholds_.size() ? UINT64_MAX : Rng::threshold(cumulative);
+        }
+    }
+
+    // Market-wide system events fire when the clock crosses their time, as do
+    // auction bursts (one NOII or Cross Trade per symbol, sharing a timestamp);
+    // otherwise the next order-flow event is generated.
+    size_t orderFlowOrEvent(uint8_t* out) {
+        if (burst_ != Burst::None) {
+            return auctionMessage(out);
+        }
+        advanceClock();
+        uint64_t now = clock_.ns_since_midnight;
+        if (phase_ == Phase::PreMarket && now >= config_.market_open_ns) {
+            phase_ = Phase::Market;
+            startBurst(Burst::Cross);
+            return systemEvent(out, static_cast<char>(SystemEventCode::StartOfMarket));
+        }
+        if (phase_ == Phase::Market && now >= config_.market_close_ns) {
+            phase_ = Phase::PostMarket;
+            startBurst(Burst::Cross);
+            return systemEvent(out, static_cast<char>(SystemEventCode::EndOfMarket));
+        }
+        if (phase_ == Phase::PostMarket && now >= config_.system_close_ns) {
+            phase_ = Phase::EndOfSystem;
+            return systemEvent(out, static_cast<char>(SystemEventCode::EndOfSystem));
+        }
+        if (now >= next_noii_ns_) {
+            startBurst(Burst::Imbalance);
+            return auctionMessage(out);
+        }
+        return orderFlow(out);
+    }
+
+    void startBurst(Burst burst) {
+        uint64_t now = clock_.ns_since_midnight;
+        next_noii_ns_ = auction_.nextDissemination(now, config_.market_open_ns, config_.market_close_ns);
+        if (burst == Burst::Cross && !auction_.active()) {
+            return;
+        }
+        last_prices_.resize(symbols_.size());
+        for (size_t i = 0; i < symbols_.size(); ++i) {
+            last_prices_[i] = symbols_[i].last_price;
+        }
+        if (burst == Burst::Imbalance) {
+            if (auction_.active()) {
+                auction_.accumulate(last_prices_);
+            } else {
+                char cross_type = now < config_.market_open_ns ? 'O' : 'C';
+                auction_.begin(cross_type, last_prices_, config_.tick, config_.round_lot);
+            }
+        }
+        auction_.snapshotBook(orders_, symbols_.size());
+        burst_ = burst;
+        burst_cursor_ = 0;
+    }
+
+    size_t auctionMessage(uint8_t* out) {
+        size_t index = burst_cursor_++;
+        size_t length = burst_ == Burst::Imbalance ? noii(out, index) : crossTrade(out, index);
+        if (burst_cursor_ == symbols_.size()) {
+            if (burst_ == Burst::Cross) auction_.end();
+            burst_ = Burst::None;
+        }
+        return length;
+    }
+
+    size_t orderFlow(uint8_t* out) {
+        Event event = pickEvent();
+        if (orders_.empty() && event != Event::Trade) {
+            event = Event::Add;
+        } else if (event == Event::Add && orders_.size() >= config_.max_live_orders) {
+            event = Event::Delete;
+        }
+        switch (event) {
+            case Event::Add: return addOrder(out);
+            case Event::Execute: return executeOrder(out);
+            case Event::Cancel: return cancelOrder(out);
+            case Event::Delete: return deleteOrder(out);
+            case Event::Replace: return replaceOrder(out);
+            case Event::Trade: return trade(out);
+        }
+        return 0;
+    }
+
+    Event pickEvent() {
+        const std::array<uint64_t, 6> &thresholds =
+            sampler_ ? sampler_->eventThresholds(clock_.ns_since_midnight) : event_thresholds_;
+        uint64_t draw = rng_.next();
+        size_t i = 0;
+        while (i + 1 < thresholds.size() && draw >= thresholds[i]) ++i;
+        return static_cast<Event>(i);
+    }
+
+    void advanceClock() {
+        if (sampler_) {
+            clock_.advanceBy(sampler_->gap(rng_, clock_.ns_since_midnight));
+            return;
+        }
+        double gap = -std::log(1.0 - rng_.uniform()) * config_.mean_interarrival_ns;
+        clock_.advanceBy(static_cast<uint64_t>(gap) + 1);
+    }
+
+    uint16_t nextTracking() { return ++tracking_number_; }
+
+    template <typename Msg>
+    static size_t emit(uint8_t* out, const Msg &msg) {
+        std::memcpy(out, &msg, sizeof(Msg));
+        return sizeof(Msg);
+    }
+
+    size_t systemEvent(uint8_t* out, char event_code) {
+        SystemEventMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::SystemEvent);
+        msg.stock_locate = 0;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.event_code = event_code;
+        return emit(out, msg);
+    }
+
+    size_t stockDirectory(uint8_t* out, uint16_t stock_locate) {
+        StockDirectoryMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::StockDirectory);
+        msg.stock_locate = stock_locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.stock = symbols_[stock_locate - 1].stock;
+        msg.market_category = 'Q';
+        msg.financial_status_indicator = 'N';
+        msg.round_lot_size = config_.round_lot;
+        msg.round_lots_only = 'N';
+        msg.issue_classification = 'C';
+        msg.issue_subtype = {'Z', ' '};
+        msg.authenticity = 'P';
+        msg.short_sale_threshold_indicator = 'N';
+        msg.ipo_flag = 'N';
+        msg.LULDReference_price_tier = '1';
+        msg.etp_flag = 'N';
+        msg.etp_leverage_factor = 0;
+        msg.inverse_indicator = 'N';
+        return emit(out, msg);
+    }
+
+    size_t addOrder(uint8_t* out) {
+        uint16_t locate = static_cast<uint16_t>(1 + (sampler_ ? sampler_->symbol(rng_) : rng_.below(symbols_.size())));
+        SymbolState &symbol = symbols_[locate - 1];
+        char side = (rng_.next() & 1) ? static_cast<char>(Side::Buy) : static_cast<char>(Side::Sell);
+        // Offsets are in ticks away from the last price; a captured profile
+        // can also yield negative (marketable) offsets.
+        int64_t ticks = sampler_ ? sampler_->offsetTicks(rng_)
+                                 : static_cast<int64_t>(rng_.below(config_.max_price_offset_ticks + 1));
+        int64_t offset = ticks * config_.tick;
+        int64_t away = side == static_cast<char>(Side::Buy) ? static_cast<int64_t>(symbol.last_price) - offset
+                                                            : static_cast<int64_t>(symbol.last_price) + offset;
+        uint32_t price = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(away, config_.tick), UINT32_MAX));
+        uint32_t shares = sampler_ ? sampler_->shares(rng_)
+                                   : config_.round_lot * static_cast<uint32_t>(1 + rng_.below(10));
+        LiveOrder order{next_order_ref_++, shares, price, locate, side};
+        insertOrder(order);
+
+        AddOrderMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::AddOrder);
+        msg.stock_locate = locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.order_reference_number = order.order_ref;
+        msg.side = side;
+        msg.shares = shares;
+        msg.stock = symbol.stock;
+        msg.price = price;
+        return emit(out, msg);
+    }
+
+    size_t executeOrder(uint8_t* out) {
+        size_t index = rng_.below(orders_.size());
+        LiveOrder order = orders_[index];
+        uint32_t executed = std::min(order.shares, config_.round_lot * static_cast<uint32_t>(1 + rng_.below(5)));
+        symbols_[order.stock_locate - 1].last_price = order.price;
+        if (executed == order.shares) {
+            removeOrder(index);
+        } else {
+            orders_[index].shares -= executed;
+        }
+
+        OrderExecutedMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::OrderExecuted);
+        msg.stock_locate = order.stock_locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.order_reference_number = order.order_ref;
+        msg.executed_shares = executed;
+        msg.match_number = ++match_number_;
+        return emit(out, msg);
+    }
+
+    size_t cancelOrder(uint8_t* out) {
+        size_t index = rng_.below(orders_.size());
+        LiveOrder &order = orders_[index];
+        if (order.shares <= config_.round_lot) {
+            return deleteAt(out, index);
+        }
+        uint32_t cancelled = config_.round_lot * static_cast<uint32_t>(1 + rng_.below(order.shares / config_.round_lot - 1));
+        order.shares -= cancelled;
+
+        OrderCancelMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::OrderCancel);
+        msg.stock_locate = order.stock_locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.order_reference_number = order.order_ref;
+        msg.cancelled_shares = cancelled;
+        return emit(out, msg);
+    }
+
+    size_t deleteOrder(uint8_t* out) {
+        return deleteAt(out, rng_.below(orders_.size()));
+    }
+
+    size_t deleteAt(uint8_t* out, size_t index) {
+        LiveOrder order = orders_[index];
+        removeOrder(index);
+
+        OrderDeleteMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::OrderDelete);
+        msg.stock_locate = order.stock_locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.order_reference_number = order.order_ref;
+        return emit(out, msg);
+    }
+
+    size_t replaceOrder(uint8_t* out) {
+        size_t index = rng_.below(orders_.size());
+        LiveOrder original = orders_[index];
+        LiveOrder replacement = original;
+        replacement.order_ref = next_order_ref_++;
+        replacement.shares = config_.round_lot * static_cast<uint32_t>(1 + rng_.below(10));
+        int32_t move = static_cast<int32_t>(rng_.below(5)) - 2;
+        int64_t price = static_cast<int64_t>(original.price) + move * static_cast<int64_t>(config_.tick);
+        replacement.price = price > 0 ? static_cast<uint32_t>(price) : config_.tick;
+        removeOrder(index);
+        insertOrder(replacement);
+
+        OrderReplaceMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::OrderReplace);
+        msg.stock_locate = original.stock_locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.original_order_ref = original.order_ref;
+        msg.new_order_ref = replacement.order_ref;
+        msg.shares = replacement.shares;
+        msg.price = replacement.price;
+        return emit(out, msg);
+    }
+
+    // Execution against a non-displayed order.
+    size_t trade(uint8_t* out) {
+        uint16_t locate = static_cast<uint16_t>(1 + rng_.below(symbols_.size()));
+        SymbolState &symbol = symbols_[locate - 1];
+
+        TradeMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::Trade);
+        msg.stock_locate = locate;
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.order_reference_number = 0;
+        msg.side = static_cast<char>(Side::Buy);
+        msg.shares = config_.round_lot * static_cast<uint32_t>(1 + rng_.below(5));
+        msg.stock = symbol.stock;
+        msg.price = symbol.last_price;
+        msg.match_number = ++match_number_;
+        return emit(out, msg);
+    }
+
+    size_t noii(uint8_t* out, size_t index) {
+        SymbolState &symbol = symbols_[index];
+        AuctionResult result = auction_.compute(index, symbol.last_price);
+
+        NOIIMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::NOII);
+        msg.stock_locate = static_cast<uint16_t>(index + 1);
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.paired_shares = result.paired_shares;
+        msg.imbalance_shares = result.imbalance_shares;
+        msg.imbalance_direction = result.imbalance_direction;
+        msg.stock = symbol.stock;
+        msg.far_price = result.far_price;
+        msg.near_price = result.near_price;
+        msg.current_reference_price = result.reference_price;
+        msg.cross_type = auction_.crossType();
+        msg.price_variation_indicator = result.price_variation_indicator;
+        return emit(out, msg);
+    }
+
+    size_t crossTrade(uint8_t* out, size_t index) {
+        SymbolState &symbol = symbols_[index];
+        CrossPoint point = auction_.cross(index, symbol.last_price);
+        if (point.paired_shares > 0) {
+            symbol.last_price = point.price;
+        }
+
+        CrossTradeMessage msg{};
+        msg.message_type = static_cast<char>(MessageType::CrossTrade);
+        msg.stock_locate = static_cast<uint16_t>(index + 1);
+        msg.tracking_number = nextTracking();
+        packTimestamp(msg.timestamp, clock_.ns_since_midnight);
+        msg.shares = point.paired_shares;
+        msg.stock = symbol.stock;
+        msg.cross_price = point.paired_shares > 0 ? point.price : symbol.last_price;
+        msg.match_number = point.paired_shares > 0 ? ++match_number_ : 0;  // Nothing traded, no match
+        msg.cross_type = auction_.crossType();
+        return emit(out, msg);
+    }
+
+    void insertOrder(const LiveOrder &order) {
+        orders_.push_back(order);
+    }
+
+    // Swap-and-pop keeps the live set dense so a random order is one draw away.
+    void removeOrder(size_t index) {
+        orders_[index] = orders_.back();
+        orders_.pop_back();
+    }
+
+    SessionConfig config_;
+    Rng rng_;
+    Timestamp clock_{};
+    Phase phase_ = Phase::StartOfMessages;
+    size_t directory_index_ = 0;
+    std::array<uint64_t, 6> event_thresholds_{};
+    std::shared_ptr<ProfileSampler> sampler_;   // Set when sampling a captured profile
+    std::vector<SymbolState> symbols_;
+    std::vector<LiveOrder> orders_;
+    uint16_t tracking_number_ = 0;
+    uint64_t next_order_ref_ = 1;
+    uint64_t match_number_ = 0;
+    uint64_t messages_ = 0;
+
+    AuctionSimulator auction_;
+    uint64_t next_noii_ns_ = UINT64_MAX;
+    Burst burst_ = Burst::None;
+    size_t burst_cursor_ = 0;
+    std::vector<uint32_t> last_prices_;
+};
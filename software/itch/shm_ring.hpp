@@ -0,0 +1,384 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Shared-memory broadcast ring for co-located consumers.
+//
+// One publisher writes sequenced ITCH messages into fixed 64 byte slots of a
+// memfd or POSIX shm object; any number of processes map it read-only and
+// follow along at their own pace. The publisher never waits for readers. A
+// reader that falls more than a ring's worth behind is lapped: it detects
+// this from the sequence numbers, counts what it lost and resumes from the
+// oldest message still held.
+//
+// shm_open needs -lrt on glibc older than 2.34.
+
+constexpr uint64_t kShmRingMagic = 0x474E495248435449ULL; // "ITCHRING"
+constexpr uint32_t kShmRingVersion = 1;
+constexpr size_t kShmRingHeaderSize = 4096;
+constexpr size_t kShmRingSlotSize = 64;
+constexpr size_t kShmRingMaxMessage = kShmRingSlotSize - sizeof(uint64_t) - sizeof(uint16_t);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs address-free 64-bit atomics");
+
+struct ShmRingHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t slot_count;                           // Power of two
+    alignas(64) std::atomic<uint64_t> write_sequence; // Last published sequence, 0 before the first
+    alignas(64) std::atomic<uint64_t> closed;         // Non-zero once the publisher has finished
+};
+
+struct ShmRingSlot {
+    std::atomic<uint64_t> sequence;   // 0 while being written
+    uint16_t length;
+    uint8_t data[kShmRingMaxMessage];
+};
+
+static_assert(sizeof(ShmRingHeader) <= kShmRingHeaderSize, "ShmRingHeader must fit its page");
+static_assert(sizeof(ShmRingSlot) == kShmRingSlotSize, "ShmRingSlot must be one cache line");
+
+inline size_t shmRingBytes(uint64_t slot_count) {
+    return kShmRingHeaderSize + slot_count * kShmRingSlotSize;
+}
+
+class ShmRingPublisher {
+public:
+    // An empty name creates an anonymous memfd (share it via fd() or
+    // /proc/<pid>/fd/<fd>); otherwise a POSIX shm object "/name" is created,
+    // replacing any stale one. Huge pages are used where the kernel allows.
+    ShmRingPublisher(const std::string &name, uint64_t slot_count) : name_(name) {
+        // One slot is always kept as slack, so a smaller ring holds nothing.
+        if (slot_count < 2) {
+            throw std::invalid_argument("ShmRingPublisher: slot_count must be at least 2");
+        }
+        uint64_t rounded = 1;
+        while (rounded < slot_count) rounded <<= 1;
+        bytes_ = shmRingBytes(rounded);
+
+        if (name_.empty()) {
+            openMemfd();
+        } else {
+            ::shm_unlink(name_.c_str());
+            fd_ = ::shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+            if (fd_ < 0) {
+                throw std::runtime_error("ShmRingPublisher: shm_open failed for " + name_);
+            }
+            if (::ftruncate(fd_, static_cast<off_t>(bytes_)) < 0) {
+                cleanup();
+                throw std::runtime_error("ShmRingPublisher: ftruncate failed");
+            }
+        }
+
+        void* base = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+        if (base == MAP_FAILED) {
+            cleanup();
+            throw std::runtime_error("ShmRingPublisher: mmap failed");
+        }
+        base_ = static_cast<uint8_t*>(base);
+#ifdef MADV_HUGEPAGE
+        if (!huge_pages_) {
+            // Transparent huge pages for shmem, if enabled in
+            // /sys/kernel/mm/transparent_hugepage/shmem_enabled.
+            ::madvise(base_, bytes_, MADV_HUGEPAGE);
+        }
+#endif
+
+        header_ = reinterpret_cast<ShmRingHeader*>(base_);
+        slots_ = reinterpret_cast<ShmRingSlot*>(base_ + kShmRingHeaderSize);
+        header_->slot_size = kShmRingSlotSize;
+        header_->slot_count = rounded;
+        header_->version = kShmRingVersion;
+        header_->write_sequence.store(0, std::memory_order_relaxed);
+        header_->closed.store(0, std::memory_order_relaxed);
+        mask_ = rounded - 1;
+        // Readers check the magic last, so publish it after everything else.
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = kShmRingMagic;
+    }
+
+    ~ShmRingPublisher() {
+        close();
+        cleanup();
+    }
+
+    ShmRingPublisher(const ShmRingPublisher &) = delete;
+    ShmRingPublisher &operator=(const ShmRingPublisher &) = delete;
+
+    // Publishes one message and returns its sequence number, or 0 if the
+    // message is larger than a slot (no ITCH 5.0 message is).
+    uint64_t publish(const void* message, uint16_t length) {
+        if (length > kShmRingMaxMessage) {
+            return 0;
+        }
+        uint64_t sequence = ++sequence_;
+        ShmRingSlot &slot = slots_[sequence & mask_];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.length = length;
+        std::memcpy(slot.data, message, length);
+        slot.sequence.store(sequence, std::memory_order_release);
+        header_->write_sequence.store(sequence, std::memory_order_release);
+        return sequence;
+    }
+
+    // Tells readers no more messages will follow.
+    void close() {
+        if (header_ != nullptr) {
+            header_->closed.store(1, std::memory_order_release);
+        }
+    }
+
+    int fd() const { return fd_; }
+    const std::string &name() const { return name_; }
+    uint64_t slotCount() const { return mask_ + 1; }
+    uint64_t lastSequence() const { return sequence_; }
+    bool hugePages() const { return huge_pages_; }
+
+private:
+    void openMemfd() {
+#ifdef MFD_HUGETLB
+        fd_ = ::memfd_create("itch-ring", MFD_CLOEXEC | MFD_HUGETLB);
+        if (fd_ >= 0) {
+            // hugetlbfs sizes must be a multiple of the huge page size.
+            const size_t huge = 2u << 20;
+            size_t huge_bytes = (bytes_ + huge - 1) / huge * huge;
+            // Mapping reserves the huge pages, so a trial map tells us whether
+            // enough are available before committing to them.
+            if (::ftruncate(fd_, static_cast<off_t>(huge_bytes)) == 0) {
+                void* probe = ::mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+                if (probe != MAP_FAILED) {
+                    ::munmap(probe, huge_bytes);
+                    bytes_ = huge_bytes;
+                    huge_pages_ = true;
+                    return;
+                }
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+#endif
+        fd_ = ::memfd_create("itch-ring", MFD_CLOEXEC);
+        if (fd_ < 0 || ::ftruncate(fd_, static_cast<off_t>(bytes_)) < 0) {
+            cleanup();
+            throw std::runtime_error("ShmRingPublisher: memfd_create failed");
+        }
+    }
+
+    void cleanup() {
+        if (base_ != nullptr) {
+            ::munmap(base_, bytes_);
+            base_ = nullptr;
+            header_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        if (!name_.empty()) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    std::string name_;
+    int fd_ = -1;
+    size_t bytes_ = 0;
+    bool huge_pages_ = false;
+    uint8_t* base_ = nullptr;
+    ShmRingHeader* header_ = nullptr;
+    ShmRingSlot* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t sequence_ = 0;
+};
+
+// A message as it sits in the ring. data points into shared memory; check
+// ShmRingReader::stillValid() after decoding to be sure it was not overwritten.
+struct ShmMessageView {
+    uint64_t sequence;
+    const uint8_t* data;
+    uint16_t length;
+};
+
+enum class ShmReadStatus : uint8_t {
+    Message,   // view holds the next message
+    Empty,     // caught up with the publisher
+    Lapped,    // fell behind; skipped to the oldest held message
+    Closed,    // caught up and the publisher has finished
+};
+
+class ShmRingReader {
+public:
+    // Attaches to a named ring created by ShmRingPublisher.
+    explicit ShmRingReader(const std::string &name) {
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error("ShmRingReader: shm_open failed for " + name);
+        }
+        attach(fd);
+    }
+
+    // Attaches to a ring by descriptor, e.g. a memfd received over a socket or
+    // opened through /proc/<pid>/fd/<fd>. The descriptor is duplicated.
+    static ShmRingReader fromFd(int fd) {
+        return ShmRingReader(::dup(fd), FromFd{});
+    }
+
+    ShmRingReader(ShmRingReader &&other) noexcept { *this = std::move(other); }
+    ShmRingReader &operator=(ShmRingReader &&other) noexcept {
+        std::swap(base_, other.base_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(header_, other.header_);
+        std::swap(slots_, other.slots_);
+        std::swap(mask_, other.mask_);
+        std::swap(next_, other.next_);
+        std::swap(lapped_, other.lapped_);
+        std::swap(lost_, other.lost_);
+        return *this;
+    }
+
+    ~ShmRingReader() {
+        if (base_ != nullptr) {
+            ::munmap(base_, bytes_);
+        }
+    }
+
+    // Starts from the newest message instead of the oldest held one.
+    void seekToLatest() {
+        next_ = header_->write_sequence.load(std::memory_order_acquire) + 1;
+    }
+
+    // Fetches the next message without copying it.
+    ShmReadStatus tryRead(ShmMessageView &view) {
+        uint64_t head = header_->write_sequence.load(std::memory_order_acquire);
+        if (next_ > head) {
+            return header_->closed.load(std::memory_order_acquire) ? ShmReadStatus::Closed : ShmReadStatus::Empty;
+        }
+        uint64_t oldest = oldestHeld();
+        if (next_ < oldest) {
+            resumeFrom(oldest);
+            return ShmReadStatus::Lapped;
+        }
+        const ShmRingSlot &slot = slots_[next_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != next_) {
+            // Overwritten between reading head and the slot.
+            resumeFrom(oldestHeld());
+            return ShmReadStatus::Lapped;
+        }
+        view.sequence = next_;
+        view.data = slot.data;
+        view.length = slot.length;
+        if (view.length > kShmRingMaxMessage || !stillValid(view)) {
+            resumeFrom(oldestHeld());
+            return ShmReadStatus::Lapped;
+        }
+        ++next_;
+        return ShmReadStatus::Message;
+    }
+
+    // True if the message behind view has not been overwritten since tryRead.
+    bool stillValid(const ShmMessageView &view) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slots_[view.sequence & mask_].sequence.load(std::memory_order_relaxed) == view.sequence;
+    }
+
+    // Copies up to max_messages messages out and hands each to
+    // fn(sequence, data, length) after validating the copy. Returns the number
+    // delivered; lapping is absorbed and counted.
+    template <typename Fn>
+    size_t poll(Fn &&fn, size_t max_messages = 64) {
+        size_t delivered = 0;
+        uint8_t copy[kShmRingMaxMessage];
+        ShmMessageView view;
+        while (delivered < max_messages) {
+            ShmReadStatus status = tryRead(view);
+            if (status == ShmReadStatus::Lapped) continue;
+            if (status != ShmReadStatus::Message) break;
+            std::memcpy(copy, view.data, view.length);
+            if (!stillValid(view)) {
+                resumeFrom(oldestHeld());
+                continue;
+            }
+            fn(view.sequence, copy, view.length);
+            ++delivered;
+        }
+        return delivered;
+    }
+
+    bool closed() const {
+        return header_->closed.load(std::memory_order_acquire) &&
+               next_ > header_->write_sequence.load(std::memory_order_acquire);
+    }
+    uint64_t nextSequence() const { return next_; }
+    uint64_t lappedCount() const { return lapped_; }   // Times the reader was lapped
+    uint64_t lostMessages() const { return lost_; }    // Messages skipped because of lapping
+    uint64_t slotCount() const { return mask_ + 1; }
+
+private:
+    struct FromFd {};
+
+    ShmRingReader(int fd, FromFd) {
+        if (fd < 0) {
+            throw std::runtime_error("ShmRingReader: bad descriptor");
+        }
+        attach(fd);
+    }
+
+    void attach(int fd) {
+        struct stat st{};
+        if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < kShmRingHeaderSize) {
+            ::close(fd);
+            throw std::runtime_error("ShmRingReader: ring not initialized");
+        }
+        bytes_ = static_cast<size_t>(st.st_size);
+        void* base = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("ShmRingReader: mmap failed");
+        }
+        base_ = static_cast<uint8_t*>(base);
+        header_ = reinterpret_cast<const ShmRingHeader*>(base_);
+        if (header_->magic != kShmRingMagic || header_->version != kShmRingVersion ||
+            header_->slot_size != kShmRingSlotSize || shmRingBytes(header_->slot_count) > bytes_) {
+            ::munmap(base_, bytes_);
+            base_ = nullptr;
+            throw std::runtime_error("ShmRingReader: not an ITCH ring or incompatible version");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        slots_ = reinterpret_cast<const ShmRingSlot*>(base_ + kShmRingHeaderSize);
+        mask_ = header_->slot_count - 1;
+        next_ = oldestHeld();
+    }
+
+    uint64_t oldestHeld() const {
+        uint64_t head = header_->write_sequence.load(std::memory_order_acquire);
+        // Leave one slot of slack for the message being written.
+        return head > mask_ ? head - mask_ + 1 : 1;
+    }
+
+    void resumeFrom(uint64_t sequence) {
+        if (sequence > next_) {
+            lost_ += sequence - next_;
+            next_ = sequence;
+        }
+        ++lapped_;
+    }
+
+    uint8_t* base_ = nullptr;
+    size_t bytes_ = 0;
+    const ShmRingHeader* header_ = nullptr;
+    const ShmRingSlot* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t next_ = 1;
+    uint64_t lapped_ = 0;
+    uint64_t lost_ = 0;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+// Bounded single-producer single-consumer queue between two threads of one
+// process. Each side keeps a cached copy of the other side's index and only
+// reloads it when the ring looks full (producer) or empty (consumer), so in
+// steady state a push or pop touches no cache line the other thread writes.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side. Returns false if the ring is full.
+    bool tryPush(const T &value) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ > mask_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ > mask_) return false;
+        }
+        slots_[head & mask_] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool tryPop(T &value) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) return false;
+        }
+        value = slots_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Current depth; safe to read from any thread, exact only when quiescent.
+    size_t size() const {
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        return head >= tail ? static_cast<size_t>(head - tail) : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    alignas(64) std::atomic<uint64_t> head_{0};   // Written by the producer
+    uint64_t cached_tail_ = 0;
+    alignas(64) std::atomic<uint64_t> tail_{0};   // Written by the consumer
+    uint64_t cached_head_ = 0;
+    alignas(64) std::vector<T> slots_;
+    uint64_t mask_ = 0;
+};
@@ -0,0 +1,319 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "moldudp64.hpp" // big-endian helpers
+#include "session.hpp"   // synthetic order flow
+#include "metrics.hpp"   // live metrics page
+
+// Bounded-memory streaming output. Encoded messages are written straight into
+// fixed-size chunks drawn from a preallocated pool; full chunks are handed to a
+// sink on a separate thread and then recycled. When the sink falls behind the
+// pool runs dry and the producer blocks, so resident memory never grows past
+// the configured budget however long the run is.
+
+struct StreamConfig {
+    size_t chunk_size = 1 << 20;                       // Bytes per output chunk
+    size_t memory_budget = 256u << 20;                 // Total bytes held by the buffer pool
+    std::chrono::milliseconds report_interval{10000};  // 0 disables periodic reporting
+};
+
+struct StreamStats {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t chunks_written = 0;
+    uint64_t producer_stalls = 0;      // Times the producer waited for a free chunk
+    uint64_t stall_ns = 0;             // Total time spent waiting
+    size_t pool_chunks = 0;
+    size_t pool_free = 0;              // Chunks not holding unsent data
+    size_t rss_bytes = 0;              // Resident set of the whole process
+};
+
+// Resident set size from /proc/self/statm, or 0 where unavailable.
+inline size_t currentRssBytes() {
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long pages_total = 0, pages_resident = 0;
+    int fields = std::fscanf(statm, "%lu %lu", &pages_total, &pages_resident);
+    std::fclose(statm);
+    return fields == 2 ? pages_resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE)) : 0;
+}
+
+struct StreamChunk {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size = 0;
+};
+
+// Fixed set of chunks allocated (and touched) once up front.
+class BufferPool {
+public:
+    BufferPool(size_t chunk_count, size_t chunk_size) : chunk_size_(chunk_size) {
+        chunks_.resize(chunk_count);
+        for (StreamChunk &chunk : chunks_) {
+            chunk.data.reset(new uint8_t[chunk_size]);
+            std::memset(chunk.data.get(), 0, chunk_size);
+            free_.push_back(&chunk);
+        }
+    }
+
+    // Blocks until a chunk is free. Returns the chunk and adds any wait to stall_ns.
+    StreamChunk* acquire(uint64_t &stall_ns, uint64_t &stalls) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            ++stalls;
+            auto start = std::chrono::steady_clock::now();
+            available_.wait(lock, [this] { return !free_.empty(); });
+            stall_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+        StreamChunk* chunk = free_.back();
+        free_.pop_back();
+        chunk->size = 0;
+        return chunk;
+    }
+
+    void release(StreamChunk* chunk) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(chunk);
+        }
+        available_.notify_one();
+    }
+
+    size_t chunkSize() const { return chunk_size_; }
+    size_t chunkCount() const { return chunks_.size(); }
+    size_t freeCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+private:
+    size_t chunk_size_;
+    std::vector<StreamChunk> chunks_;
+    std::vector<StreamChunk*> free_;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+};
+
+// Frames messages BinaryFILE style (2 byte big-endian length, then the
+// message) into pooled chunks and delivers full chunks to sink(data, size) on
+// a writer thread. Single producer.
+class StreamWriter {
+public:
+    using Sink = std::function<void(const uint8_t*, size_t)>;
+
+    StreamWriter(const StreamConfig &config, Sink sink)
+        : config_(validated(config)),
+          pool_(std::max<size_t>(2, config_.memory_budget / config_.chunk_size), config_.chunk_size),
+          sink_(std::move(sink)) {
+        current_ = pool_.acquire(stall_ns_, stalls_);
+        writer_ = std::thread([this] { writeLoop(); });
+        if (config_.report_interval.count() > 0) {
+            reporter_ = std::thread([this] { reportLoop(); });
+        }
+    }
+
+    ~StreamWriter() { close(); }
+
+    StreamWriter(const StreamWriter &) = delete;
+    StreamWriter &operator=(const StreamWriter &) = delete;
+
+    // Returns space for one framed message of up to max_length bytes; the
+    // message is written in place and then committed with its actual length.
+    uint8_t* reserve(size_t max_length) {
+        if (current_->size + 2 + max_length > pool_.chunkSize()) {
+            submit();
+        }
+        return current_->data.get() + current_->size + 2;
+    }
+
+    void commit(size_t length) {
+        storeBE16(current_->data.get() + current_->size, static_cast<uint16_t>(length));
+        current_->size += 2 + length;
+        ++messages_;
+        bytes_ += 2 + length;
+    }
+
+    void append(const void* message, size_t length) {
+        std::memcpy(reserve(length), message, length);
+        commit(length);
+    }
+
+    // Hands the partially filled chunk to the sink.
+    void flush() {
+        if (current_ != nullptr && current_->size > 0) {
+            submit();
+        }
+    }
+
+    // Flushes, waits for the sink to drain and stops the background threads.
+    void close() {
+        if (closed_) return;
+        flush();
+        publish();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ready_cv_.notify_all();
+        stop_cv_.notify_all();
+        if (writer_.joinable()) writer_.join();
+        if (reporter_.joinable()) reporter_.join();
+        if (current_ != nullptr) {
+            pool_.release(current_);
+            current_ = nullptr;
+        }
+    }
+
+    // Full chunks waiting for the sink; lock-free, for live metrics.
+    size_t queueDepth() const { return queued_.load(std::memory_order_relaxed); }
+    size_t poolChunks() const { return pool_.chunkCount(); }
+
+    StreamStats stats() const {
+        StreamStats stats;
+        stats.messages = messages_published_.load(std::memory_order_relaxed);
+        stats.bytes = bytes_published_.load(std::memory_order_relaxed);
+        stats.chunks_written = chunks_written_.load(std::memory_order_relaxed);
+        stats.producer_stalls = stalls_published_.load(std::memory_order_relaxed);
+        stats.stall_ns = stall_ns_published_.load(std::memory_order_relaxed);
+        stats.pool_chunks = pool_.chunkCount();
+        stats.pool_free = pool_.freeCount();
+        stats.rss_bytes = currentRssBytes();
+        return stats;
+    }
+
+private:
+    // Every chunk must hold at least one framed message of the largest size.
+    static const StreamConfig &validated(const StreamConfig &config) {
+        if (config.chunk_size < 2 + kMaxMessageSize) {
+            throw std::invalid_argument("StreamWriter: chunk_size must hold at least one framed message");
+        }
+        return config;
+    }
+
+    void submit() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(current_);
+        }
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        ready_cv_.notify_one();
+        publish();
+        current_ = pool_.acquire(stall_ns_, stalls_);
+        publish();
+    }
+
+    void publish() {
+        messages_published_.store(messages_, std::memory_order_relaxed);
+        bytes_published_.store(bytes_, std::memory_order_relaxed);
+        stalls_published_.store(stalls_, std::memory_order_relaxed);
+        stall_ns_published_.store(stall_ns_, std::memory_order_relaxed);
+    }
+
+    void writeLoop() {
+        for (;;) {
+            StreamChunk* chunk = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_cv_.wait(lock, [this] { return closed_ || !ready_.empty(); });
+                if (ready_.empty()) return;
+                chunk = ready_.front();
+                ready_.pop_front();
+            }
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            sink_(chunk->data.get(), chunk->size);
+            chunks_written_.fetch_add(1, std::memory_order_relaxed);
+            pool_.release(chunk);
+        }
+    }
+
+    void reportLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_cv_.wait_for(lock, config_.report_interval, [this] { return closed_; })) {
+            lock.unlock();
+            StreamStats s = stats();
+            std::cerr << "[stream] messages=" << s.messages
+                      << " bytes=" << s.bytes
+                      << " chunks=" << s.chunks_written
+                      << " pool_free=" << s.pool_free << "/" << s.pool_chunks
+                      << " stalls=" << s.producer_stalls
+                      << " stall_ms=" << s.stall_ns / 1'000'000
+                      << " rss_mb=" << s.rss_bytes / (1 << 20) << "\n";
+            lock.lock();
+        }
+    }
+
+    StreamConfig config_;
+    BufferPool pool_;
+    Sink sink_;
+    StreamChunk* current_ = nullptr;
+
+    std::mutex mutex_;
+    std::condition_variable ready_cv_;   // Writer: chunks ready or closed
+    std::condition_variable stop_cv_;    // Reporter: closed
+    std::deque<StreamChunk*> ready_;
+    bool closed_ = false;
+    std::thread writer_;
+    std::thread reporter_;
+
+    // Producer-side counters, published once per chunk for stats().
+    uint64_t messages_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t stalls_ = 0;
+    uint64_t stall_ns_ = 0;
+    std::atomic<uint64_t> messages_published_{0};
+    std::atomic<uint64_t> bytes_published_{0};
+    std::atomic<uint64_t> stalls_published_{0};
+    std::atomic<uint64_t> stall_ns_published_{0};
+    std::atomic<uint64_t> chunks_written_{0};
+    std::atomic<size_t> queued_{0};
+};
+
+inline void publishStreamMetrics(MetricsPublisher &metrics, size_t stage, const OrderFlowSession &session,
+                                 const StreamWriter &writer) {
+    metrics.setSimulatedTime(session.timestamp());
+    metrics.setLiveOrders(session.liveOrderCount());
+    metrics.setStageDepth(stage, writer.queueDepth());
+    metrics.publish();
+}
+
+// Streams up to message_count messages (or the rest of the day) from session.
+// Returns the number of messages written. With metrics, every message is
+// counted and the page is refreshed at the publisher's interval.
+inline uint64_t streamSession(OrderFlowSession &session, StreamWriter &writer, uint64_t message_count,
+                              MetricsPublisher* metrics = nullptr) {
+    size_t stage = metrics != nullptr ? metrics->addStage("stream chunks", writer.poolChunks()) : 0;
+    uint64_t written = 0;
+    while (written < message_count) {
+        uint8_t* out = writer.reserve(kMaxMessageSize);
+        size_t length = session.next(out);
+        if (length == 0) break;
+        writer.commit(length);
+        ++written;
+        if (metrics != nullptr) {
+            metrics->countMessage(out, length);
+            if (metrics->due()) publishStreamMetrics(*metrics, stage, session, writer);
+        }
+    }
+    if (metrics != nullptr) {
+        publishStreamMetrics(*metrics, stage, session, writer);
+    }
+    return written;
+}
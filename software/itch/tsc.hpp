@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Cheap cycle counter. Falls back to steady_clock nanoseconds on targets
+// without an invariant TSC, in which case calibration yields 1 tick per ns.
+inline uint64_t readTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Converts TSC ticks to nanoseconds. Calibrated once at startup against
+// steady_clock; the longer the calibration window the smaller the error.
+class TscClock {
+public:
+    TscClock() = default;
+
+    static TscClock calibrate(std::chrono::milliseconds window = std::chrono::milliseconds(50)) {
+        using Clock = std::chrono::steady_clock;
+        auto wall_start = Clock::now();
+        uint64_t tsc_start = readTsc();
+        std::this_thread::sleep_for(window);
+        auto wall_end = Clock::now();
+        uint64_t tsc_end = readTsc();
+
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(wall_end - wall_start).count());
+        TscClock clock;
+        if (ns > 0.0 && tsc_end > tsc_start) {
+            clock.ticks_per_ns_ = static_cast<double>(tsc_end - tsc_start) / ns;
+        }
+        return clock;
+    }
+
+    double ticksPerNs() const { return ticks_per_ns_; }
+    double toNs(uint64_t ticks) const { return static_cast<double>(ticks) / ticks_per_ns_; }
+    uint64_t fromNs(double ns) const { return static_cast<uint64_t>(ns * ticks_per_ns_); }
+
+private:
+    double ticks_per_ns_ = 1.0;
+};
@@ -0,0 +1,290 @@
+// Publishes the synthetic feed as MoldUDP64 over loopback or multicast UDP.
+//
+//   g++ -std=c++17 -O2 -pthread udp_publish.cpp generator.cpp -o udp_publish
+//   ./udp_publish [--dest ADDR] [--port P] [--interface ADDR] [--messages N] [--per-packet M]
+//                 [--batch B] [--gso S] [--gso-padding P] [--rate R] [--txtime] [--receiver-batch B]
+//                 [--no-receiver] [--retransmit-port P] [--replay-capacity N]
+//                 [--drop P] [--drop-burst N] [--duplicate P] [--reorder P] [--reorder-depth N]
+//                 [--delay P] [--delay-packets N] [--truncate P] [--impair-seed S]
+//
+// Order flow is generated and framed up front so the send loop measures only
+// the publisher. --batch sets datagrams per sendmmsg call, --gso the most
+// packets per UDP_SEGMENT super-datagram, --gso-padding the bytes a packet
+// may be padded to join one (0, the default, puts no padding on the wire) and
+// --per-packet the messages per MoldUDP64 packet (0 fills each packet). --rate paces in packets per second, spinning
+// on the TSC or, with --txtime, by stamping departure times for the kernel.
+// Unless --no-receiver is given a receiver thread on this host checks
+// sequence continuity and reports what was lost where. --retransmit-port
+// records every framed message in a replay ring of --replay-capacity messages
+// and serves MoldUDP64 re-requests on that loopback port; the receiver asks
+// for each of its gaps once the feed ends. --drop, --duplicate, --reorder,
+// --delay and --truncate impair data packets with the given probability on
+// their way to the socket (seeded by --impair-seed); the end of session
+// packets are sent after every held packet has been drained.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "constant.hpp"       // ITCH constants
+#include "session.hpp"        // order flow
+#include "moldudp64.hpp"      // framing
+#include "rate_shaper.hpp"    // user-space pacing
+#include "udp_publisher.hpp"  // sendmmsg publisher and receiver
+#include "retransmit.hpp"     // replay ring and re-request server
+#include "impairment.hpp"     // fault injection
+
+namespace {
+
+struct Options {
+    UdpPublisherConfig publisher;
+    UdpReceiverConfig receiver;
+    uint64_t messages = 5'000'000;
+    uint16_t per_packet = 0;
+    double rate = 0.0;
+    bool txtime = false;
+    bool receive = true;
+    uint16_t retransmit_port = 0;
+    size_t replay_capacity = 1 << 22;
+    ImpairmentConfig impairment;
+};
+
+struct Packets {
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;    // offsets.size() == packet count + 1
+    uint64_t messages = 0;          // Framed; fewer than asked if the session ended
+
+    size_t count() const { return offsets.size() - 1; }
+    const uint8_t* packet(size_t i) const { return data.data() + offsets[i]; }
+    size_t length(size_t i) const { return offsets[i + 1] - offsets[i]; }
+};
+
+const MoldSession kSession = makeMoldSession("UDPPUB");
+
+// Builder is MoldPacketBuilder, or RecordingPacketBuilder to keep every
+// framed message for retransmission.
+template <typename Builder>
+Packets framePackets(Builder &builder, uint64_t messages, uint16_t per_packet) {
+    Packets packets;
+    packets.offsets.push_back(0);
+    SessionConfig config;
+    OrderFlowSession session(config);
+    auto emit = [&] {
+        size_t length = builder.finish();
+        packets.data.insert(packets.data.end(), builder.data(), builder.data() + length);
+        packets.offsets.push_back(packets.data.size());
+        builder.reset();
+    };
+    uint8_t message[kMaxMessageSize];
+    for (uint64_t i = 0; i < messages; ++i) {
+        size_t length = session.next(message);
+        if (length == 0) break;
+        if (!builder.append(message, static_cast<uint16_t>(length))) {
+            emit();
+            builder.append(message, static_cast<uint16_t>(length));
+        }
+        ++packets.messages;
+        if (per_packet > 0 && builder.count() >= per_packet) emit();
+    }
+    if (!builder.empty()) emit();
+    // End of session, sent a few times since it can be lost like any datagram.
+    size_t control = builder.control(kMoldEndOfSession);
+    for (int i = 0; i < 3; ++i) {
+        packets.data.insert(packets.data.end(), builder.data(), builder.data() + control);
+        packets.offsets.push_back(packets.data.size());
+    }
+    return packets;
+}
+
+void printRow(const char* name, uint64_t value) {
+    std::cout << "  " << std::left << std::setw(52) << name << std::right << std::setw(14) << value << "\n";
+}
+
+int run(const Options &options) {
+    std::unique_ptr<ReplayRing> ring;
+    std::unique_ptr<RetransmitServer> server;
+    Packets packets;
+    if (options.retransmit_port != 0) {
+        ring = std::make_unique<ReplayRing>(options.replay_capacity);
+        RecordingPacketBuilder builder(kSession, *ring);
+        packets = framePackets(builder, options.messages, options.per_packet);
+        server = std::make_unique<RetransmitServer>(*ring, kSession, options.retransmit_port);
+        server->start();
+    } else {
+        MoldPacketBuilder builder(kSession);
+        packets = framePackets(builder, options.messages, options.per_packet);
+    }
+
+    UdpPublisherConfig publisher_config = options.publisher;
+    if (options.txtime) publisher_config.txtime_rate = options.rate;
+    std::unique_ptr<UdpReceiver> receiver;
+    if (options.receive) {
+        UdpReceiverConfig receiver_config = options.receiver;
+        if (server) receiver_config.retransmit_port = server->port();
+        receiver = std::make_unique<UdpReceiver>(receiver_config);
+        receiver->start();
+    }
+
+    UdpPublisher publisher(publisher_config);
+    RateShaperConfig shaper_config;
+    shaper_config.messages_per_second = options.rate;
+    shaper_config.burst_messages = static_cast<uint32_t>(std::max<size_t>(1, publisher_config.batch));
+    bool spin = options.rate > 0.0 && !options.txtime;
+    TscClock clock = spin ? TscClock::calibrate(std::chrono::milliseconds(100)) : TscClock{};
+    RateShaper shaper(shaper_config, clock);
+
+    Impairment impairment(options.impairment);
+    auto send = [&](const uint8_t* packet, size_t length) { publisher.send(packet, length); };
+    size_t data_packets = packets.count() - 3;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < packets.count(); ++i) {
+        if (spin) shaper.acquire();
+        if (i < data_packets) {
+            impairment.process(packets.packet(i), packets.length(i), send);
+            continue;
+        }
+        if (i == data_packets) impairment.drain(send);
+        publisher.send(packets.packet(i), packets.length(i));
+    }
+    publisher.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (receiver) receiver->stop();
+    if (server) server->stop();
+
+    const UdpPublisherStats &sent = publisher.stats();
+    double n = static_cast<double>(std::max<uint64_t>(1, sent.packets));
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "publisher: " << sent.packets << " packets (" << data_packets << " data), " << sent.bytes
+              << " bytes in " << seconds << " s, " << sent.packets / seconds / 1e6 << " Mpps, "
+              << sent.bytes / seconds / 1e6 << " MB/s\n";
+    std::cout << "  " << std::left << std::setw(52) << "sendmmsg calls" << std::right << std::setw(14) << sent.syscalls << "\n"
+              << "  " << std::left << std::setw(52) << "syscalls per packet" << std::right << std::setw(14)
+              << std::setprecision(4) << static_cast<double>(sent.syscalls) / n << "\n"
+              << "  " << std::left << std::setw(52) << "packets per sendmmsg entry" << std::right << std::setw(14)
+              << static_cast<double>(sent.packets) / static_cast<double>(std::max<uint64_t>(1, sent.datagrams)) << "\n"
+              << "  " << std::left << std::setw(52) << "GSO padding bytes" << std::right << std::setw(14) << sent.padding << "\n"
+              << "  " << std::left << std::setw(52) << "short sends" << std::right << std::setw(14) << sent.short_sends << "\n"
+              << "  " << std::left << std::setw(52) << "dropped by the kernel on send" << std::right << std::setw(14) << sent.dropped << "\n"
+              << "  " << std::left << std::setw(52) << "ICMP port unreachable, retried" << std::right << std::setw(14) << sent.refused << "\n"
+              << "  " << std::left << std::setw(52) << "SO_TXTIME errors" << std::right << std::setw(14) << sent.txtime_errors << "\n";
+    if (impairment.active()) {
+        const ImpairmentStats &impaired = impairment.stats();
+        std::cout << "impairment: seed " << options.impairment.seed << "\n";
+        printRow("data packets in", impaired.units_in);
+        printRow("data packets out", impaired.units_out);
+        printRow("dropped", impaired.dropped);
+        printRow("duplicated", impaired.duplicated);
+        printRow("reordered", impaired.reordered);
+        printRow("delayed", impaired.delayed);
+        printRow("truncated", impaired.truncated);
+    }
+    if (server) {
+        RetransmitStats retransmit = server->stats();
+        std::cout << "retransmission: replay ring of " << ring->capacity() << " messages, port " << server->port() << "\n";
+        printRow("re-requests served", retransmit.requests);
+        printRow("messages resent", retransmit.hits);
+        printRow("messages no longer held", retransmit.misses);
+        printRow("malformed or foreign requests", retransmit.rejected);
+        printRow("response packets sent", retransmit.packets_sent);
+        printRow("response packets sendto() refused", retransmit.send_failures);
+    }
+    if (!receiver) return 0;
+
+    const UdpReceiverStats &received = receiver->stats();
+    uint64_t expected = packets.messages;
+    std::cout << "receiver: " << received.packets << " packets, " << received.messages << " messages, "
+              << (received.end_of_session ? "end of session seen" : "no end of session") << "\n"
+              << "  " << std::left << std::setw(52) << "recvmmsg calls" << std::right << std::setw(14) << received.syscalls << "\n"
+              << "  " << std::left << std::setw(52) << "sequence gaps" << std::right << std::setw(14) << received.gaps << "\n"
+              << "  " << std::left << std::setw(52) << "messages missing in gaps" << std::right << std::setw(14) << received.missing << "\n"
+              << "  " << std::left << std::setw(52) << "messages missing at the tail" << std::right << std::setw(14)
+              << (received.next_sequence <= expected ? expected + 1 - received.next_sequence : 0) << "\n"
+              << "  " << std::left << std::setw(52) << "duplicate packets" << std::right << std::setw(14) << received.duplicates << "\n"
+              << "  " << std::left << std::setw(52) << "dropped by the kernel on receive" << std::right << std::setw(14) << received.socket_drops << "\n";
+    if (server) {
+        printRow("re-requests sent", received.requests);
+        printRow("missing messages recovered", received.recovered);
+        printRow("missing messages not recovered", received.unrecovered);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dest" && i + 1 < argc) {
+            options.publisher.destination = options.receiver.group = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.publisher.port = options.receiver.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--interface" && i + 1 < argc) {
+            options.publisher.interface_address = options.receiver.interface_address = argv[++i];
+        } else if (arg == "--messages" && i + 1 < argc) {
+            options.messages = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--per-packet" && i + 1 < argc) {
+            options.per_packet = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.publisher.batch = std::stoull(argv[++i]);
+        } else if (arg == "--gso" && i + 1 < argc) {
+            options.publisher.gso_segments = std::stoull(argv[++i]);
+        } else if (arg == "--gso-padding" && i + 1 < argc) {
+            options.publisher.gso_max_padding = std::stoull(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rate = std::stod(argv[++i]);
+        } else if (arg == "--txtime") {
+            options.txtime = true;
+        } else if (arg == "--receiver-batch" && i + 1 < argc) {
+            options.receiver.batch = std::stoull(argv[++i]);
+        } else if (arg == "--no-receiver") {
+            options.receive = false;
+        } else if (arg == "--retransmit-port" && i + 1 < argc) {
+            options.retransmit_port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--replay-capacity" && i + 1 < argc) {
+            options.replay_capacity = std::max<size_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--drop" && i + 1 < argc) {
+            options.impairment.drop_probability = std::stod(argv[++i]);
+        } else if (arg == "--drop-burst" && i + 1 < argc) {
+            options.impairment.drop_burst_length = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--duplicate" && i + 1 < argc) {
+            options.impairment.duplicate_probability = std::stod(argv[++i]);
+        } else if (arg == "--reorder" && i + 1 < argc) {
+            options.impairment.reorder_probability = std::stod(argv[++i]);
+        } else if (arg == "--reorder-depth" && i + 1 < argc) {
+            options.impairment.reorder_depth = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--delay" && i + 1 < argc) {
+            options.impairment.delay_probability = std::stod(argv[++i]);
+        } else if (arg == "--delay-packets" && i + 1 < argc) {
+            options.impairment.delay_units = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--truncate" && i + 1 < argc) {
+            options.impairment.truncate_probability = std::stod(argv[++i]);
+        } else if (arg == "--impair-seed" && i + 1 < argc) {
+            options.impairment.seed = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--dest ADDR] [--port P] [--interface ADDR] [--messages N]"
+                      << " [--per-packet M] [--batch B] [--gso S] [--gso-padding P] [--rate R] [--txtime] [--receiver-batch B]"
+                      << " [--no-receiver] [--retransmit-port P] [--replay-capacity N] [--drop P] [--drop-burst N]"
+                      << " [--duplicate P] [--reorder P] [--reorder-depth N] [--delay P] [--delay-packets N]"
+                      << " [--truncate P] [--impair-seed S]\n";
+            return 1;
+        }
+    }
+    if (options.txtime && options.rate <= 0.0) {
+        std::cerr << "--txtime needs --rate\n";
+        return 1;
+    }
+
+    try {
+        return run(options);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
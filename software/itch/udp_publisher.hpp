@@ -0,0 +1,593 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/net_tstamp.h>
+
+#include "moldudp64.hpp"  // framing
+#include "retransmit.hpp" // re-requests
+
+// Batched MoldUDP64 publisher for loopback or multicast UDP.
+//
+// Finished packets are queued into a preallocated batch and handed to the
+// kernel with one sendmmsg call per batch. Two optional offloads cut the
+// per-packet cost further:
+//
+//   UDP_SEGMENT (GSO)  Several packets go down the stack as one super-datagram
+//                      and are split into separate datagrams at the bottom.
+//                      GSO needs every segment but the last to be the same
+//                      size, so a super-datagram is a run of equal-length
+//                      packets, optionally closed by one shorter packet. With
+//                      gso_max_padding > 0, packets up to that many bytes
+//                      short are zero-padded to join the run; MoldUDP64
+//                      decoders stop after message_count blocks and ignore
+//                      the padding. The default sends no padding at all.
+//   SO_TXTIME          Each datagram carries its scheduled departure time
+//                      (CLOCK_MONOTONIC) and the kernel paces them. This only
+//                      takes effect on a device with the fq qdisc; elsewhere
+//                      the stamps are ignored and packets leave immediately.
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef SO_TXTIME
+#define SO_TXTIME 61
+#define SCM_TXTIME SO_TXTIME
+#endif
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+constexpr size_t kUdpMaxPacket = kMoldHeaderSize + kMoldMaxPayload;
+constexpr size_t kUdpMaxGsoSegments = 64;        // Kernel limit per super-datagram (UDP_MAX_SEGMENTS)
+constexpr size_t kUdpMaxGsoBytes = 65507;        // Largest UDP payload over IPv4
+
+inline bool isMulticastAddress(const in_addr &address) {
+    return IN_MULTICAST(ntohl(address.s_addr));
+}
+
+inline in_addr parseIpv4(const std::string &text, const char* what) {
+    in_addr address{};
+    if (::inet_pton(AF_INET, text.c_str(), &address) != 1) {
+        throw std::runtime_error(std::string(what) + ": bad IPv4 address " + text);
+    }
+    return address;
+}
+
+inline uint64_t monotonicNs() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+struct UdpPublisherConfig {
+    std::string destination = "127.0.0.1";   // Unicast address or multicast group
+    uint16_t port = 26477;
+    std::string interface_address;           // Multicast egress interface; empty lets the kernel route
+    uint8_t multicast_ttl = 1;
+    bool multicast_loop = true;              // Deliver to receivers on this host
+    size_t batch = 32;                       // Datagrams (or GSO super-datagrams) per sendmmsg
+    size_t gso_segments = 0;                 // Most packets per GSO super-datagram; 0 disables GSO
+    size_t gso_max_padding = 0;              // Bytes a packet may be padded to join a GSO run
+    double txtime_rate = 0.0;                // Packets per second paced by SO_TXTIME; 0 disables
+    int send_buffer = 16 << 20;
+};
+
+struct UdpPublisherStats {
+    uint64_t packets = 0;          // MoldUDP64 packets handed to the kernel
+    uint64_t datagrams = 0;        // sendmmsg entries accepted, one per GSO super-datagram
+    uint64_t bytes = 0;            // Payload bytes sent, padding included
+    uint64_t padding = 0;          // Bytes of GSO padding among them
+    uint64_t syscalls = 0;         // sendmmsg calls
+    uint64_t short_sends = 0;      // Calls that accepted only part of the batch
+    uint64_t dropped = 0;          // Packets the kernel had no buffer for (ENOBUFS, EAGAIN)
+    uint64_t refused = 0;          // ICMP port unreachable reports (nobody listening); the send is retried
+    uint64_t txtime_errors = 0;    // Packets reported on the error queue by SO_TXTIME
+};
+
+class UdpPublisher {
+public:
+    explicit UdpPublisher(const UdpPublisherConfig &config)
+        : config_(config),
+          segments_(std::max<size_t>(1, std::min(config.gso_segments, kUdpMaxGsoSegments))),
+          group_capacity_(segments_ > 1 ? kUdpMaxGsoBytes : kUdpMaxPacket),
+          batch_(std::max<size_t>(1, config.batch)) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) {
+            throw std::runtime_error("UdpPublisher: socket() failed");
+        }
+        try {
+            configure();
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+        buffer_.assign(batch_ * group_capacity_, 0);
+        groups_.resize(batch_);
+        iovecs_.resize(batch_);
+        headers_.resize(batch_);
+        control_.assign(batch_ * kControlSpace, 0);
+    }
+
+    ~UdpPublisher() {
+        try {
+            flush();
+        } catch (const std::exception &) {
+            // Nothing useful to do with a send failure while closing.
+        }
+        ::close(fd_);
+    }
+
+    UdpPublisher(const UdpPublisher &) = delete;
+    UdpPublisher &operator=(const UdpPublisher &) = delete;
+
+    // Queues one finished MoldUDP64 packet, sending the batch once it is full.
+    void send(const uint8_t* packet, size_t length) {
+        if (length == 0 || length > kUdpMaxPacket) {
+            throw std::length_error("UdpPublisher: packet is empty or larger than a MoldUDP64 packet");
+        }
+        if (used_ == 0 || !joins(groups_[used_ - 1], length)) {
+            if (used_ == batch_) flush();
+            Group &group = groups_[used_++];
+            group = Group{};
+            group.offset = (used_ - 1) * group_capacity_;
+            group.segment = static_cast<uint16_t>(length);
+            if (config_.txtime_rate > 0.0) group.txtime = nextTxtime();
+        }
+        Group &group = groups_[used_ - 1];
+        uint8_t* slot = buffer_.data() + group.offset + group.count * group.segment;
+        std::memcpy(slot, packet, length);
+        if (length < group.segment) {
+            size_t pad = group.segment - length;
+            if (pad <= config_.gso_max_padding) {
+                std::memset(slot + length, 0, pad);
+                group.padding += pad;
+            } else {
+                group.closed = true;   // Shorter tail segment: no padding needed
+            }
+        }
+        group.last_length = static_cast<uint16_t>(length);
+        ++group.count;
+        if (config_.txtime_rate > 0.0) ++scheduled_;
+    }
+
+    // Sends whatever is queued. ENOBUFS and EAGAIN count the refused
+    // datagram as dropped; any other send error throws std::system_error.
+    void flush() {
+        if (used_ == 0) return;
+        size_t groups = used_;
+        used_ = 0;
+        for (size_t i = 0; i < groups; ++i) prepare(i);
+
+        size_t sent = 0;
+        while (sent < groups) {
+            int n = ::sendmmsg(fd_, headers_.data() + sent, static_cast<unsigned>(groups - sent), 0);
+            ++stats_.syscalls;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == ECONNREFUSED) {
+                    // A connected socket reports an earlier datagram's ICMP
+                    // error here; this datagram was not sent, so retry it.
+                    ++stats_.refused;
+                    continue;
+                }
+                if (errno == ENOBUFS || errno == EAGAIN) {
+                    stats_.dropped += groups_[sent].count;
+                    ++sent;
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "UdpPublisher: sendmmsg failed");
+            }
+            if (static_cast<size_t>(n) < groups - sent) ++stats_.short_sends;
+            for (size_t i = sent; i < sent + static_cast<size_t>(n); ++i) {
+                stats_.packets += groups_[i].count;
+                stats_.bytes += iovecs_[i].iov_len;
+                stats_.padding += groups_[i].padding;
+                ++stats_.datagrams;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        if (config_.txtime_rate > 0.0) drainErrorQueue();
+    }
+
+    const UdpPublisherStats &stats() const { return stats_; }
+    size_t maxSegments() const { return segments_; }
+    int fd() const { return fd_; }
+
+private:
+    static constexpr size_t kControlSpace = CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(uint64_t));
+    static constexpr uint64_t kTxtimeLeadNs = 100'000; // First departure, ahead of the first send
+
+    // One sendmmsg entry: a single packet, or a GSO run of packets laid out
+    // segment bytes apart.
+    struct Group {
+        size_t offset = 0;            // Into buffer_
+        uint16_t segment = 0;         // GSO segment size: the first packet's length
+        uint16_t count = 0;
+        uint16_t last_length = 0;     // Unpadded length of the last packet
+        bool closed = false;          // Ended by a shorter packet
+        uint64_t padding = 0;
+        uint64_t txtime = 0;
+    };
+
+    bool joins(const Group &group, size_t length) const {
+        return !group.closed && group.count < segments_ && length <= group.segment &&
+               static_cast<size_t>(group.count + 1) * group.segment <= group_capacity_;
+    }
+
+    void configure() {
+        ::setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &config_.send_buffer, sizeof(config_.send_buffer));
+        destination_.sin_family = AF_INET;
+        destination_.sin_port = htons(config_.port);
+        destination_.sin_addr = parseIpv4(config_.destination, "UdpPublisher");
+        if (isMulticastAddress(destination_.sin_addr)) {
+            int ttl = config_.multicast_ttl;
+            int loop = config_.multicast_loop ? 1 : 0;
+            ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+            ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+            if (!config_.interface_address.empty()) {
+                in_addr interface = parseIpv4(config_.interface_address, "UdpPublisher");
+                if (::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) < 0) {
+                    throw std::runtime_error("UdpPublisher: cannot use interface " + config_.interface_address);
+                }
+            }
+        }
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&destination_), sizeof(destination_)) < 0) {
+            throw std::runtime_error("UdpPublisher: connect() failed for " + config_.destination);
+        }
+        if (config_.txtime_rate > 0.0) {
+            sock_txtime txtime{};
+            txtime.clockid = CLOCK_MONOTONIC;
+            txtime.flags = SOF_TXTIME_REPORT_ERRORS;
+            if (::setsockopt(fd_, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) < 0) {
+                throw std::runtime_error("UdpPublisher: SO_TXTIME is not supported");
+            }
+            interval_ns_ = 1e9 / config_.txtime_rate;
+        }
+    }
+
+    // Departure time of the next packet: a fixed schedule from the first
+    // packet, so lateness in user space does not turn into rate error.
+    uint64_t nextTxtime() {
+        if (txtime_start_ == 0) {
+            txtime_start_ = monotonicNs() + kTxtimeLeadNs;
+        }
+        return txtime_start_ + static_cast<uint64_t>(static_cast<double>(scheduled_) * interval_ns_);
+    }
+
+    void prepare(size_t index) {
+        const Group &group = groups_[index];
+        iovec &iov = iovecs_[index];
+        iov.iov_base = buffer_.data() + group.offset;
+        iov.iov_len = static_cast<size_t>(group.count - 1) * group.segment + group.last_length;
+
+        mmsghdr &header = headers_[index];
+        std::memset(&header, 0, sizeof(header));
+        header.msg_hdr.msg_iov = &iov;
+        header.msg_hdr.msg_iovlen = 1;
+
+        uint8_t* control = control_.data() + index * kControlSpace;
+        size_t control_length = 0;
+        header.msg_hdr.msg_control = control;
+        header.msg_hdr.msg_controllen = kControlSpace;
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&header.msg_hdr);
+        if (group.count > 1) {
+            uint16_t segment = group.segment;
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(segment));
+            std::memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+            control_length += CMSG_SPACE(sizeof(segment));
+            cmsg = CMSG_NXTHDR(&header.msg_hdr, cmsg);
+        }
+        if (config_.txtime_rate > 0.0) {
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+            std::memcpy(CMSG_DATA(cmsg), &group.txtime, sizeof(uint64_t));
+            control_length += CMSG_SPACE(sizeof(uint64_t));
+        }
+        header.msg_hdr.msg_controllen = control_length;
+        if (control_length == 0) header.msg_hdr.msg_control = nullptr;
+    }
+
+    // SO_TXTIME reports packets it dropped (e.g. a missed deadline) on the
+    // socket error queue; count and discard them.
+    void drainErrorQueue() {
+        uint8_t data[64];
+        uint8_t control[128];
+        for (;;) {
+            iovec iov{data, sizeof(data)};
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (::recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+            ++stats_.txtime_errors;
+        }
+    }
+
+    UdpPublisherConfig config_;
+    size_t segments_;
+    size_t group_capacity_;             // Buffer bytes per sendmmsg entry
+    size_t batch_;
+    int fd_ = -1;
+    sockaddr_in destination_{};
+
+    std::vector<uint8_t> buffer_;       // batch groups of group_capacity_ bytes
+    std::vector<Group> groups_;
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> headers_;
+    std::vector<uint8_t> control_;
+    size_t used_ = 0;                   // Groups holding queued packets
+
+    double interval_ns_ = 0.0;
+    uint64_t txtime_start_ = 0;
+    uint64_t scheduled_ = 0;
+
+    UdpPublisherStats stats_;
+};
+
+struct UdpReceiverConfig {
+    std::string group = "127.0.0.1";          // Address the publisher sends to
+    uint16_t port = 26477;
+    std::string interface_address;            // Interface to join a multicast group on
+    size_t batch = 64;                        // Datagrams per recvmmsg
+    int receive_buffer = 64 << 20;
+    uint32_t idle_timeout_ms = 200;           // Give up this long after stop() with nothing arriving
+    uint16_t retransmit_port = 0;             // Re-request gaps from a RetransmitServer here (0: off)
+    std::string retransmit_address = "127.0.0.1";
+};
+
+struct UdpReceiverStats {
+    uint64_t packets = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t syscalls = 0;            // recvmmsg calls that returned data
+    uint64_t missing = 0;             // Messages skipped by sequence gaps
+    uint64_t gaps = 0;                // Distinct gaps
+    uint64_t duplicates = 0;          // Packets entirely at or below the expected sequence
+    uint64_t socket_drops = 0;        // Datagrams the kernel dropped on a full receive buffer
+    uint64_t requests = 0;            // Re-requests sent to the retransmission server
+    uint64_t recovered = 0;           // Missing messages it sent back
+    uint64_t unrecovered = 0;         // Missing messages it no longer held or never answered for
+    uint64_t next_sequence = 1;
+    bool end_of_session = false;
+};
+
+// Stand-in for a downstream consumer: receives the feed on its own thread and
+// checks sequence continuity. Kernel-side drops come from SO_RXQ_OVFL, so a
+// gap can be told apart from a loss in the socket buffer. With a
+// retransmit_port, every gap (including one before the end of session) is
+// re-requested once the feed ends, one MoldUDP64 request at a time.
+class UdpReceiver {
+public:
+    explicit UdpReceiver(const UdpReceiverConfig &config) : config_(config), batch_(std::max<size_t>(1, config.batch)) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) {
+            throw std::runtime_error("UdpReceiver: socket() failed");
+        }
+        try {
+            configure();
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+    }
+
+    ~UdpReceiver() {
+        stop();
+        ::close(fd_);
+    }
+
+    UdpReceiver(const UdpReceiver &) = delete;
+    UdpReceiver &operator=(const UdpReceiver &) = delete;
+
+    void start() {
+        if (thread_.joinable()) return;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    // Returns once the end of session packet has arrived, or nothing has
+    // arrived for idle_timeout_ms after this call.
+    void stop() {
+        stopping_.store(true, std::memory_order_release);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    // Valid after stop().
+    const UdpReceiverStats &stats() const { return stats_; }
+
+private:
+    void configure() {
+        int reuse = 1;
+        int overflow = 1;
+        ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &config_.receive_buffer, sizeof(config_.receive_buffer));
+        ::setsockopt(fd_, SOL_SOCKET, SO_RXQ_OVFL, &overflow, sizeof(overflow));
+        timeval timeout{0, 50'000};
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        in_addr group = parseIpv4(config_.group, "UdpReceiver");
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config_.port);
+        addr.sin_addr = group;
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            throw std::runtime_error("UdpReceiver: bind() failed on port " + std::to_string(config_.port));
+        }
+        if (isMulticastAddress(group)) {
+            ip_mreq membership{};
+            membership.imr_multiaddr = group;
+            membership.imr_interface.s_addr = config_.interface_address.empty()
+                ? htonl(INADDR_ANY) : parseIpv4(config_.interface_address, "UdpReceiver").s_addr;
+            if (::setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+                throw std::runtime_error("UdpReceiver: cannot join " + config_.group);
+            }
+        }
+    }
+
+    struct Gap {
+        uint64_t first;
+        uint64_t count;
+    };
+
+    void run() {
+        receiveFeed();
+        if (config_.retransmit_port != 0) recover();
+    }
+
+    void receiveFeed() {
+        std::vector<uint8_t> buffer(batch_ * kUdpMaxPacket);
+        std::vector<uint8_t> control(batch_ * kReceiveControlSpace);
+        std::vector<iovec> iovecs(batch_);
+        std::vector<mmsghdr> headers(batch_);
+        uint64_t idle_since = 0;
+        for (;;) {
+            for (size_t i = 0; i < batch_; ++i) {
+                iovecs[i] = iovec{buffer.data() + i * kUdpMaxPacket, kUdpMaxPacket};
+                std::memset(&headers[i], 0, sizeof(mmsghdr));
+                headers[i].msg_hdr.msg_iov = &iovecs[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+                headers[i].msg_hdr.msg_control = control.data() + i * kReceiveControlSpace;
+                headers[i].msg_hdr.msg_controllen = kReceiveControlSpace;
+            }
+            int n = ::recvmmsg(fd_, headers.data(), static_cast<unsigned>(batch_), MSG_WAITFORONE, nullptr);
+            if (n <= 0) {
+                if (!stopping_.load(std::memory_order_acquire)) {
+                    idle_since = 0;
+                    continue;
+                }
+                uint64_t now = monotonicNs();
+                if (idle_since == 0) idle_since = now;
+                if (now - idle_since > static_cast<uint64_t>(config_.idle_timeout_ms) * 1'000'000ULL) break;
+                continue;
+            }
+            idle_since = 0;
+            ++stats_.syscalls;
+            for (int i = 0; i < n; ++i) {
+                readDropCounter(headers[static_cast<size_t>(i)].msg_hdr);
+                if (!receive(buffer.data() + static_cast<size_t>(i) * kUdpMaxPacket, headers[static_cast<size_t>(i)].msg_len)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    // Returns false on the end of session packet.
+    bool receive(const uint8_t* packet, size_t length) {
+        if (length < kMoldHeaderSize) return true;
+        MoldHeader header = readMoldHeader(packet);
+        session_ = header.session;
+        if (header.message_count == kMoldEndOfSession) {
+            // Its sequence is the next one the publisher would have sent.
+            if (header.sequence_number > stats_.next_sequence) {
+                gaps_.push_back(Gap{stats_.next_sequence, header.sequence_number - stats_.next_sequence});
+            }
+            stats_.end_of_session = true;
+            return false;
+        }
+        ++stats_.packets;
+        stats_.bytes += length;
+        if (header.message_count == 0) return true;   // Heartbeat
+        uint64_t end = header.sequence_number + header.message_count;
+        if (end <= stats_.next_sequence) {
+            ++stats_.duplicates;
+            return true;
+        }
+        if (header.sequence_number > stats_.next_sequence) {
+            stats_.missing += header.sequence_number - stats_.next_sequence;
+            ++stats_.gaps;
+            gaps_.push_back(Gap{stats_.next_sequence, header.sequence_number - stats_.next_sequence});
+        }
+        stats_.messages += forEachMoldMessage(packet, length, [](uint64_t, const uint8_t*, uint16_t) {});
+        stats_.next_sequence = end;
+        return true;
+    }
+
+    void recover() {
+        int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            for (const Gap &gap : gaps_) stats_.unrecovered += gap.count;
+            return;
+        }
+        sockaddr_in server{};
+        server.sin_family = AF_INET;
+        server.sin_port = htons(config_.retransmit_port);
+        timeval timeout{static_cast<time_t>(config_.idle_timeout_ms / 1000),
+                        static_cast<suseconds_t>(config_.idle_timeout_ms % 1000 * 1000)};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        bool connected = ::inet_pton(AF_INET, config_.retransmit_address.c_str(), &server.sin_addr) == 1
+            && ::connect(fd, reinterpret_cast<sockaddr*>(&server), sizeof(server)) == 0;
+
+        std::vector<uint8_t> buffer(kUdpMaxPacket);
+        for (const Gap &gap : gaps_) {
+            for (uint64_t done = 0; done < gap.count;) {
+                uint16_t count = static_cast<uint16_t>(
+                    std::min<uint64_t>(gap.count - done, RetransmitServer::kMaxMessagesPerRequest));
+                uint64_t served = connected ? requestRange(fd, gap.first + done, count, buffer.data()) : 0;
+                stats_.recovered += served;
+                stats_.unrecovered += count - served;
+                done += count;
+            }
+        }
+        ::close(fd);
+    }
+
+    // Sends one re-request and returns how many of its messages came back in
+    // order before the server answered with a zero-count packet or went quiet.
+    uint64_t requestRange(int fd, uint64_t first, uint16_t count, uint8_t* buffer) {
+        auto request = makeMoldRequest(session_, first, count);
+        if (::send(fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size())) return 0;
+        ++stats_.requests;
+        uint64_t next = first;
+        uint64_t end = first + count;
+        while (next < end) {
+            ssize_t n = ::recv(fd, buffer, kUdpMaxPacket, 0);
+            if (n < 0) break;
+            if (static_cast<size_t>(n) < kMoldHeaderSize) continue;
+            MoldHeader header = readMoldHeader(buffer);
+            if (header.sequence_number != next) continue;    // Late answer to an earlier request
+            if (header.message_count == 0) break;             // Not held any more
+            next += forEachMoldMessage(buffer, static_cast<size_t>(n), [](uint64_t, const uint8_t*, uint16_t) {});
+        }
+        return std::min(next, end) - first;
+    }
+
+    void readDropCounter(msghdr &msg) {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t drops = 0;
+                std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                stats_.socket_drops = drops;
+            }
+        }
+    }
+
+    static constexpr size_t kReceiveControlSpace = CMSG_SPACE(sizeof(uint32_t));
+
+    UdpReceiverConfig config_;
+    size_t batch_;
+    int fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+    UdpReceiverStats stats_;
+    MoldSession session_{};
+    std::vector<Gap> gaps_;
+};